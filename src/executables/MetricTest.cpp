@@ -93,51 +93,51 @@ int main(){
 	cout << " * g3inv[zz]=";
 	pass = (pass and print_test(g3inv.data[izz],1.0));
 
-// Cholesky decomposition requires a positive definite matrix
-//	cout << "|==============|" << endl;
-//	cout << "| 3 Weird Test |" << endl;
-//	cout << "|==============|" << endl;
-//	g3.data[ixx] = 0;
-//	g3.data[iyy] = 0;
-//	g3.data[izz] = 0;
-//	g3.data[ixy] = 1;
-//	g3.data[ixz] = 1;
-//	g3.data[iyz] = 1;
-//	cout << "kup={" << kup[0] << ","<<kup[1]<<","<<kup[2]<<"}" << endl;
-//
-//	det = g3.det();
-//	cout << " * Determinant=";
-//	pass = (pass and print_test(det,2.0);
-//
-//	klow = g3.lower(kup);
-//	cout << " * klow[0]=";
-//	pass = (pass and print_test(klow[0],5);
-//	cout << " * klow[1]=";
-//	pass = (pass and print_test(klow[1],4);
-//	cout << " * klow[2]=";
-//	pass = (pass and print_test(klow[2],3);
-//
-//	g3inv = g3.inverse();
-//	cout << " * g3inv[xx]=";
-//	pass = (pass and print_test(g3inv.data[ixx],-0.5);
-//	cout << " * g3inv[xy]=";
-//	pass = (pass and print_test(g3inv.data[ixy],0.5);
-//	cout << " * g3inv[xz]=";
-//	pass = (pass and print_test(g3inv.data[ixz],0.5);
-//	cout << " * g3inv[yy]=";
-//	pass = (pass and print_test(g3inv.data[iyy],-0.5);
-//	cout << " * g3inv[yz]=";
-//	pass = (pass and print_test(g3inv.data[iyz],0.5);
-//	cout << " * g3inv[zz]=";
-//	pass = (pass and print_test(g3inv.data[izz],-0.5);
-//
-//	kup = g3inv.lower(klow);
-//	cout << " * kup[0]=";
-//	pass = (pass and print_test(kup[0],1);
-//	cout << " * kup[1]=";
-//	pass = (pass and print_test(kup[1],2);
-//	cout << " * kup[2]=";
-//	pass = (pass and print_test(kup[2],3);
+	// the closed-form inverse does not need a positive definite matrix
+	cout << "|==============|" << endl;
+	cout << "| 3 Weird Test |" << endl;
+	cout << "|==============|" << endl;
+	g3.data[ixx] = 0;
+	g3.data[iyy] = 0;
+	g3.data[izz] = 0;
+	g3.data[ixy] = 1;
+	g3.data[ixz] = 1;
+	g3.data[iyz] = 1;
+	cout << "kup={" << kup[0] << ","<<kup[1]<<","<<kup[2]<<"}" << endl;
+
+	det = g3.det();
+	cout << " * Determinant=";
+	pass = (pass and print_test(det,2.0));
+
+	klow = g3.lower(kup);
+	cout << " * klow[0]=";
+	pass = (pass and print_test(klow[0],5));
+	cout << " * klow[1]=";
+	pass = (pass and print_test(klow[1],4));
+	cout << " * klow[2]=";
+	pass = (pass and print_test(klow[2],3));
+
+	g3inv = g3.inverse();
+	cout << " * g3inv[xx]=";
+	pass = (pass and print_test(g3inv.data[ixx],-0.5));
+	cout << " * g3inv[xy]=";
+	pass = (pass and print_test(g3inv.data[ixy],0.5));
+	cout << " * g3inv[xz]=";
+	pass = (pass and print_test(g3inv.data[ixz],0.5));
+	cout << " * g3inv[yy]=";
+	pass = (pass and print_test(g3inv.data[iyy],-0.5));
+	cout << " * g3inv[yz]=";
+	pass = (pass and print_test(g3inv.data[iyz],0.5));
+	cout << " * g3inv[zz]=";
+	pass = (pass and print_test(g3inv.data[izz],-0.5));
+
+	kup = g3inv.lower(klow);
+	cout << " * kup[0]=";
+	pass = (pass and print_test(kup[0],1));
+	cout << " * kup[1]=";
+	pass = (pass and print_test(kup[1],2));
+	cout << " * kup[2]=";
+	pass = (pass and print_test(kup[2],3));
 
 	cout << "|==================|" << endl;
 	cout << "| 4 Minkowski Test |" << endl;
@@ -0,0 +1,111 @@
+/*
+//  Copyright (c) 2015, California Institute of Technology and the Regents
+//  of the University of California, based on research sponsored by the
+//  United States Department of Energy. All rights reserved.
+//
+//  This file is part of Sedonu.
+//
+//  Sedonu is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Neither the name of the California Institute of Technology (Caltech)
+//  nor the University of California nor the names of its contributors 
+//  may be used to endorse or promote products derived from this software
+//  without specific prior written permission.
+//
+//  Sedonu is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Sedonu.  If not, see <http://www.gnu.org/licenses/>.
+//
+*/
+
+#include "global_options.h"
+#include "H5Cpp.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace std;
+
+// Collect Hiroki's per-zone opacity text files (opac_r<i>_theta<j>.dat) into
+// one HDF5 dataset "eas" indexed [r][theta][group][species][emis,abs,scat]
+// that Neutrino_Nagakura reads in a single call (Nagakura_opacity_file).
+
+string opacity_filename(const string& dir, const size_t ir, const size_t itheta){
+	stringstream filename;
+	filename << dir << "/opac_r" << ir << "_theta" << itheta << ".dat";
+	return filename.str();
+}
+
+bool file_exists(const string& filename){
+	ifstream f(filename.c_str());
+	return f.good();
+}
+
+int main(int argc, char* argv[]){
+	if(argc!=3){
+		cout << "Usage: nagakura_opacity_convert opacity_dir output.h5" << endl;
+		exit(1);
+	}
+	const string dir = argv[1];
+	const string outfilename = argv[2];
+
+	// count the radial zones, theta zones, and energy groups
+	size_t nr=0, ntheta=0, ngroups=0;
+	while(file_exists(opacity_filename(dir,nr,0))) nr++;
+	while(file_exists(opacity_filename(dir,0,ntheta))) ntheta++;
+	if(nr==0){
+		cout << "ERROR: no opacity files found in " << dir << endl;
+		exit(1);
+	}
+	ifstream first_file(opacity_filename(dir,0,0).c_str());
+	string line;
+	getline(first_file,line); // header
+	while(getline(first_file,line)) if(line.find_first_not_of(" \t\r")!=string::npos) ngroups++;
+	first_file.close();
+	cout << "# " << nr << " radial zones, " << ntheta << " theta zones, " << ngroups << " groups" << endl;
+
+	// read everything
+	const size_t nspecies=3, nvars=3;
+	vector<double> eas(nr*ntheta*ngroups*nspecies*nvars);
+	for(size_t ir=0; ir<nr; ir++) for(size_t itheta=0; itheta<ntheta; itheta++){
+		const string filename = opacity_filename(dir,ir,itheta);
+		ifstream opac_file(filename.c_str());
+		if(!opac_file.good()){
+			cout << "ERROR: missing " << filename << endl;
+			exit(1);
+		}
+		getline(opac_file,line); // header
+		for(size_t inu=0; inu<ngroups; inu++){
+			size_t itmp;
+			opac_file >> itmp;
+			PRINT_ASSERT(itmp,==,inu);
+			double* out = &eas[((ir*ntheta + itheta)*ngroups + inu)*nspecies*nvars];
+			for(size_t i=0; i<nspecies*nvars; i++) opac_file >> out[i];
+		}
+		if(opac_file.fail()){
+			cout << "ERROR: could not parse " << filename << endl;
+			exit(1);
+		}
+		opac_file.close();
+	}
+
+	// write the cube
+	const hsize_t dims[5] = {nr, ntheta, ngroups, nspecies, nvars};
+	H5::H5File file(outfilename, H5F_ACC_TRUNC);
+	H5::DataSpace dataspace(5,dims);
+	H5::DataSet dataset = file.createDataSet("eas",H5::PredType::IEEE_F64LE,dataspace);
+	dataset.write(&eas[0],H5::PredType::IEEE_F64LE);
+	dataset.close();
+	file.close();
+	cout << "# wrote " << outfilename << endl;
+	return 0;
+}
@@ -94,7 +94,8 @@ int main(int argc, char* argv[]){
 	vector<double> tmp_absopac(ngroups), tmp_scatopac(ngroups);
 	vector< vector<double> > tmp_delta(ngroups, vector<double>(ngroups));
 	vector< vector<double> > tmp_phi0(ngroups, vector<double>(ngroups));
-	nulib_get_eas_arrays(rho, T, ye, nulibID,
+	const double mue = nulib_eos_mue(rho, T, max(nulib_get_Yemin(), min(nulib_get_Yemax(), ye)));
+	nulib_get_eas_arrays(rho, T, ye, nulibID, mue,
 			tmp_absopac, tmp_scatopac, tmp_phi0, tmp_delta);
 
 	size_t dir_ind[2];
@@ -119,5 +120,16 @@ int main(int argc, char* argv[]){
 	cout << "a = " << abs_opac.interpolate(icube)   << " 1/cm" << endl;
 	cout << "s = " << scat_opac.interpolate(icube)  << " 1/cm" << endl;
 
+	// compare against the native C++ interpolation
+	nulib_init_native();
+	vector<double> native_absopac(ngroups), native_scatopac(ngroups);
+	nulib_get_eas_arrays_native(1, &rho, &T, &ye, nulibID, &native_absopac[0], &native_scatopac[0], 1);
+	double max_relerr = 0;
+	for(size_t ig=0; ig<ngroups; ig++){
+		if(tmp_absopac[ig]>0)  max_relerr = max(max_relerr, abs(native_absopac[ig] /tmp_absopac[ig]  - 1.));
+		if(tmp_scatopac[ig]>0) max_relerr = max(max_relerr, abs(native_scatopac[ig]/tmp_scatopac[ig] - 1.));
+	}
+	cout << "native interpolation max relative difference: " << max_relerr << endl;
+
 	return 0;
 }
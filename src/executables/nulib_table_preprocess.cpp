@@ -0,0 +1,59 @@
+/*
+//  Copyright (c) 2015, California Institute of Technology and the Regents
+//  of the University of California, based on research sponsored by the
+//  United States Department of Energy. All rights reserved.
+//
+//  This file is part of Sedonu.
+//
+//  Sedonu is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Neither the name of the California Institute of Technology (Caltech)
+//  nor the University of California nor the names of its contributors 
+//  may be used to endorse or promote products derived from this software
+//  without specific prior written permission.
+//
+//  Sedonu is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Sedonu.  If not, see <http://www.gnu.org/licenses/>.
+//
+*/
+
+#include <mpi.h>
+#include "global_options.h"
+#include "nulib_interface.h"
+#include <cstdlib>
+
+// Convert a NuLib hdf5 table into the flat format nulib_init memory-maps.
+// Inelastic and pair kernels are evaluated at every (T,eta) node here,
+// so this can take a while for large tables.
+int main(int argc, char* argv[]){
+	using namespace std;
+	if(argc!=3){
+		cout << "Usage: nulib_table_preprocess path_to_nulib_table.h5 output.bin" << endl;
+		exit(1);
+	}
+
+	MPI_Init( &argc, &argv );
+
+	cout << "initializing nulib" << endl;
+	string filename = argv[1];
+	if(nulib_is_preprocessed_table(filename)){
+		cout << "ERROR: " << filename << " is already preprocessed" << endl;
+		exit(1);
+	}
+	nulib_init(filename);
+
+	string outfilename = argv[2];
+	cout << "writing " << outfilename << endl;
+	nulib_write_preprocessed_table(outfilename);
+
+	MPI_Finalize();
+	return 0;
+}
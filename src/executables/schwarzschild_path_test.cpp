@@ -61,9 +61,15 @@ int main(int argc, char **argv)
 
 	class testTransport : public Transport{
 	public:
+		bool do_print;
+		size_t nmoves, nsubsteps;
 		void move(EinsteinHelper *eh){
-			Transport::move(eh);
+			double dlambda = eh->ds_com / eh->kup_tet[3];
+			nsubsteps += geodesic_step(eh, dlambda);
+			nmoves++;
+			if(eh->fate==moving) update_eh_k_opac(eh);
 			if(eh->xup[0]<0 or eh->xup[1]<0) eh->fate = absorbed;
+			if(not do_print) return;
 
 			for(size_t i=0; i<4; i++) cout << eh->xup[i] << "\t"; // 0-3
 			for(size_t i=0; i<4; i++) cout << eh->kup[i] << "\t"; // 4-7
@@ -74,6 +80,46 @@ int main(int argc, char **argv)
 			for(size_t i=0; i<4; i++) cout << klow[i] << "\t"; // 14-17
 			cout << endl;
 		}
+
+		// follow one neutrino until it leaves. Returns the relative
+		// change in the conserved k_t and L_z along the path
+		void trace(const vector<double>& xup, const vector<double>& kup, double* err_kt, double* err_L){
+			EinsteinHelper eh;
+			eh.xup[3] = 0;
+			for(int i=0; i<4; i++){
+				eh.xup[i] = xup[i];
+				eh.kup[i] = kup[i];
+			}
+			eh.s = 0;
+			eh.N = 1;
+			eh.N0 = eh.N;
+			eh.fate = moving;
+
+			update_eh_background(&eh);
+			update_eh_k_opac(&eh);
+			Tuple<double,4> klow = eh.g.lower<4>(eh.kup);
+			const double kt0 = klow[3];
+			const double L0 = eh.xup[0]*klow[1] - eh.xup[1]*klow[0];
+			const double kmag0 = abs(kt0);
+
+			nmoves = 0;
+			nsubsteps = 0;
+			ParticleEvent event;
+			EinsteinHelper eh_last = eh;
+			while(eh.fate==moving){
+				double ds_com;
+				which_event(&eh,&event,&ds_com);
+				eh.ds_com = ds_com;
+				eh_last = eh;
+				move(&eh);
+				if(eh.fate==moving) eh_last = eh;
+			}
+
+			// conserved quantities at the last point still on the grid
+			klow = eh_last.g.lower<4>(eh_last.kup);
+			*err_kt = abs(klow[3]-kt0) / kmag0;
+			*err_L = abs(eh_last.xup[0]*klow[1] - eh_last.xup[1]*klow[0] - L0) / kmag0;
+		}
 	};
 
 	// set up the transport module (includes the grid)
@@ -82,31 +128,33 @@ int main(int argc, char **argv)
 	sim.reset_radiation();
 
 	// start only one neutrino
-	EinsteinHelper eh;
-
 	vector<double> xup,kup;
 	xup.resize(4);
 	kup.resize(4);
 	xup = lua.vector<double>("Schwarzschild_initial_xup");
 	kup = lua.vector<double>("Schwarzschild_initial_kup");
-	eh.xup[3] = 0;
+	double err_kt, err_L;
+	sim.do_print = true;
+	sim.trace(xup, kup, &err_kt, &err_L);
+
+	// error versus step count for both integrators
+	const double min_step_size = sim.min_step_size;
+	const double max_step_size = sim.max_step_size;
+	sim.do_print = false;
+	cout << "# integrator\tparameter\tmoves\tsubsteps\terr_kt\terr_L" << endl;
 	for(int i=0; i<4; i++){
-		eh.xup[i] = xup[i];
-		eh.kup[i] = kup[i];
+		sim.geodesic_tolerance = 0;
+		sim.min_step_size = min_step_size / pow(2,i);
+		sim.max_step_size = max_step_size / pow(2,i);
+		sim.trace(xup, kup, &err_kt, &err_L);
+		cout << "# leapfrog\t" << sim.max_step_size << "\t" << sim.nmoves << "\t" << sim.nsubsteps << "\t" << err_kt << "\t" << err_L << endl;
 	}
-	eh.s = 0;
-	eh.N = 1;
-	eh.N0 = eh.N;
-	eh.fate = moving;
-
-	sim.update_eh_background(&eh);
-	sim.update_eh_k_opac(&eh);
-	ParticleEvent event;
-	while(eh.fate==moving){
-	        double ds_com;
-	        sim.which_event(&eh,&event,&ds_com);
-	        eh.ds_com = ds_com;
-		sim.move(&eh);
+	sim.min_step_size = min_step_size;
+	sim.max_step_size = max_step_size;
+	for(int i=0; i<4; i++){
+		sim.geodesic_tolerance = pow(10,-3-2*i);
+		sim.trace(xup, kup, &err_kt, &err_L);
+		cout << "# adaptive\t" << sim.geodesic_tolerance << "\t" << sim.nmoves << "\t" << sim.nsubsteps << "\t" << err_kt << "\t" << err_L << endl;
 	}
 
 	// read in time stepping parameters
@@ -263,11 +263,8 @@ void Grid::init(Lua* lua, Transport* insim)
     if(rank0) cout << "finished." << endl << flush;
 
 	// set up the data structures
-	abs_opac.resize(sim->species_list.size());
-	scat_opac.resize(sim->species_list.size());
-	inelastic_scat_opac.resize(sim->species_list.size());
-	scattering_delta.resize(sim->species_list.size());
-	partial_scat_opac.resize(sim->species_list.size());
+	eas_opac.resize(sim->species_list.size());
+	scattering_kernel.resize(sim->species_list.size());
 	spectrum.resize(sim->species_list.size());
 	vector<Axis> axes = xAxes;
 	if(do_annihilation) fourforce_annihil.set_axes(axes);
@@ -275,12 +272,11 @@ void Grid::init(Lua* lua, Transport* insim)
 	fourforce_emit.set_axes(axes);
 	l_abs.set_axes(axes);
 	l_emit.set_axes(axes);
+	mue.set_axes(axes);
 
 	axes.push_back(nu_grid_axis);
 	for(size_t s=0; s<sim->species_list.size(); s++){
-		abs_opac[s].set_axes(axes);
-		scat_opac[s].set_axes(axes);
-		inelastic_scat_opac[s].set_axes(axes);
+		if(!sim->species_list[s]->analytic_opacities) eas_opac[s].set_axes(axes);
 
 	    //===========================//
 		// intialize output spectrum // only if child didn't
@@ -297,14 +293,13 @@ void Grid::init(Lua* lua, Transport* insim)
 		PRINT_ASSERT(spectrum[s].size(),>,0);
 	}
 
+	int inelastic_bandwidth = lua->scalar<int>("inelastic_bandwidth");
+	size_t kernel_bytes = 0;
 	for(size_t s=0; s<sim->species_list.size(); s++){
-		partial_scat_opac[s].resize(nu_grid_axis.size());
-		scattering_delta[s].resize(nu_grid_axis.size());
-		for(size_t igout=0; igout<nu_grid_axis.size(); igout++){
-			partial_scat_opac[s][igout].set_axes(axes);
-			scattering_delta[s][igout].set_axes(axes);
-		}
+		scattering_kernel[s].init(eas_opac[s].size(), nu_grid_axis.size(), inelastic_bandwidth);
+		kernel_bytes += scattering_kernel[s].memory_bytes();
 	}
+	if(rank0) cout << "#   Inelastic scattering kernels: " << kernel_bytes/1024./1024. << " MB (bandwidth " << scattering_kernel[0].bandwidth << "/" << nu_grid_axis.size() << ")" << endl;
 }
 
 void Grid::write_zones(const int iw)
@@ -340,8 +335,29 @@ void Grid::write_zones(const int iw)
 	for(size_t s=0; s<distribution.size(); s++){
 		distribution[s]->write_hdf5_data(file, "distribution"+to_string(s)+"(erg|ccm,tet)");
 		spectrum[s].write_hdf5_data(file,"spectrum"+to_string(s)+"(erg|s)");
-		abs_opac[s].write_HDF5(file, "abs_opac"+to_string(s)+"(1|cm)");
-		scat_opac[s].write_HDF5(file, "scat_opac"+to_string(s)+"(1|cm)");
+
+		// opacities are stored interleaved, or not at all for analytic
+		// species; write them out separately at the zone centers
+		vector<Axis> axes = xAxes;
+		axes.push_back(nu_grid_axis);
+		ScalarMultiDArray<double,NDIMS+1> abs_opac, scat_opac;
+		abs_opac.set_axes(axes);
+		scat_opac.set_axes(axes);
+		const Species* species = sim->species_list[s];
+		for(size_t i=0; i<abs_opac.size(); i++){
+			if(species->analytic_opacities){
+				size_t dir_ind[NDIMS+1];
+				abs_opac.indices(i,dir_ind);
+				const size_t z_ind = rho.direct_index(dir_ind);
+				species->get_opacities(rho[z_ind], T[z_ind], Ye[z_ind], nu_grid_axis.mid[dir_ind[NDIMS]], &abs_opac[i], &scat_opac[i]);
+			}
+			else{
+				abs_opac[i] = eas_opac[s][i][iabs];
+				scat_opac[i] = eas_opac[s][i][iscat];
+			}
+		}
+		abs_opac.write_HDF5(file, "abs_opac"+to_string(s)+"(1|cm)");
+		scat_opac.write_HDF5(file, "scat_opac"+to_string(s)+"(1|cm)");
 	}
 
 	write_child_zones(file);
@@ -378,6 +394,101 @@ void Grid::read_zones(string filename)
 	read_child_zones(file);
 }
 
+//------------------------------------------------------------
+// Dump everything set_eas fills so a later run on the same model
+// and opacity table can skip it. key identifies the inputs.
+//------------------------------------------------------------
+void Grid::write_opacity_cache(const string filename, const unsigned long long key) const
+{
+	H5::H5File file(filename, H5F_ACC_TRUNC);
+	H5::DataSpace scalar_space;
+	H5::Attribute attr = file.openGroup("/").createAttribute("key", H5::PredType::NATIVE_ULLONG, scalar_space);
+	attr.write(H5::PredType::NATIVE_ULLONG, &key);
+	attr.close();
+
+	hsize_t dims[2] = {rho.size(), 0};
+	H5::DataSpace zone_space(1,dims);
+	H5::DataSet dataset = file.createDataSet("munue", H5::PredType::IEEE_F64LE, zone_space);
+	dataset.write(&munue.y0[0], H5::PredType::NATIVE_DOUBLE);
+	dataset = file.createDataSet("mue", H5::PredType::IEEE_F64LE, zone_space);
+	dataset.write(&mue.y0[0], H5::PredType::NATIVE_DOUBLE);
+
+	for(size_t s=0; s<eas_opac.size(); s++){
+		if(eas_opac[s].size()==0) continue; // analytic opacities
+		dims[0] = eas_opac[s].size();
+		dims[1] = 3;
+		H5::DataSpace eas_space(2,dims);
+		dataset = file.createDataSet("eas_opac"+to_string(s), H5::PredType::IEEE_F64LE, eas_space);
+		dataset.write(&eas_opac[s].y0[0], StorageType<real>::h5());
+
+		// banded kernel arrays, alias tables included
+		const ScatteringKernel& kernel = scattering_kernel[s];
+		dims[0] = kernel.size();
+		H5::DataSpace row_space(1,dims);
+		dataset = file.createDataSet("kernel_band_start"+to_string(s), H5::PredType::STD_U32LE, row_space);
+		dataset.write(&kernel.band_start[0], H5::PredType::NATIVE_UINT);
+		dims[0] = kernel.size();
+		dims[1] = kernel.bandwidth;
+		H5::DataSpace band_space(2,dims);
+		dataset = file.createDataSet("kernel_opac"+to_string(s), H5::PredType::IEEE_F32LE, band_space);
+		dataset.write(&kernel.opac[0], H5::PredType::NATIVE_FLOAT);
+		dataset = file.createDataSet("kernel_delta"+to_string(s), H5::PredType::IEEE_F32LE, band_space);
+		dataset.write(&kernel.delta[0], H5::PredType::NATIVE_FLOAT);
+		dataset = file.createDataSet("kernel_alias_prob"+to_string(s), H5::PredType::IEEE_F32LE, band_space);
+		dataset.write(&kernel.alias_prob[0], H5::PredType::NATIVE_FLOAT);
+		dataset = file.createDataSet("kernel_alias_index"+to_string(s), H5::PredType::STD_U16LE, band_space);
+		dataset.write(&kernel.alias_index[0], H5::PredType::NATIVE_USHORT);
+	}
+	dataset.close();
+	file.close();
+}
+
+// returns false (and leaves the grid alone) if the file doesn't exist,
+// was made from different inputs, or doesn't match the grid's shape
+bool Grid::read_opacity_cache(const string filename, const unsigned long long key)
+{
+	if(!ifstream(filename.c_str()).good()) return false;
+	if(H5::H5File::isHdf5(filename.c_str()) <= 0) return false;
+	H5::H5File file(filename, H5F_ACC_RDONLY);
+	H5::Group root = file.openGroup("/");
+	if(!root.attrExists("key")) return false;
+	unsigned long long file_key = 0;
+	H5::Attribute attr = root.openAttribute("key");
+	attr.read(H5::PredType::NATIVE_ULLONG, &file_key);
+	attr.close();
+	if(file_key != key) return false;
+
+	// check the shapes before touching anything
+	hsize_t dims[2];
+	for(size_t s=0; s<eas_opac.size(); s++){
+		if(eas_opac[s].size()==0) continue;
+		if(!H5Lexists(file.getId(), ("eas_opac"+to_string(s)).c_str(), H5P_DEFAULT)) return false;
+		file.openDataSet("eas_opac"+to_string(s)).getSpace().getSimpleExtentDims(dims);
+		if(dims[0]!=eas_opac[s].size() || dims[1]!=3) return false;
+		if(!H5Lexists(file.getId(), ("kernel_opac"+to_string(s)).c_str(), H5P_DEFAULT)) return false;
+		file.openDataSet("kernel_opac"+to_string(s)).getSpace().getSimpleExtentDims(dims);
+		if(dims[0]!=scattering_kernel[s].size() || dims[1]!=scattering_kernel[s].bandwidth) return false;
+	}
+	file.openDataSet("munue").getSpace().getSimpleExtentDims(dims);
+	if(dims[0]!=rho.size()) return false;
+
+	// read it all in
+	file.openDataSet("munue").read(&munue.y0[0], H5::PredType::NATIVE_DOUBLE);
+	file.openDataSet("mue").read(&mue.y0[0], H5::PredType::NATIVE_DOUBLE);
+	for(size_t s=0; s<eas_opac.size(); s++){
+		if(eas_opac[s].size()==0) continue;
+		file.openDataSet("eas_opac"+to_string(s)).read(&eas_opac[s].y0[0], StorageType<real>::h5());
+		ScatteringKernel& kernel = scattering_kernel[s];
+		file.openDataSet("kernel_band_start"+to_string(s)).read(&kernel.band_start[0], H5::PredType::NATIVE_UINT);
+		file.openDataSet("kernel_opac"+to_string(s)).read(&kernel.opac[0], H5::PredType::NATIVE_FLOAT);
+		file.openDataSet("kernel_delta"+to_string(s)).read(&kernel.delta[0], H5::PredType::NATIVE_FLOAT);
+		file.openDataSet("kernel_alias_prob"+to_string(s)).read(&kernel.alias_prob[0], H5::PredType::NATIVE_FLOAT);
+		file.openDataSet("kernel_alias_index"+to_string(s)).read(&kernel.alias_index[0], H5::PredType::NATIVE_USHORT);
+	}
+	file.close();
+	return true;
+}
+
 double Grid::zone_rest_mass(const int z_ind) const{
 	return rho[z_ind] * zone_com_3volume(z_ind);
 }
@@ -52,6 +52,7 @@
 #include "H5Cpp.h"
 #include "Axis.h"
 #include "MultiDArray.h"
+#include "ScatteringKernel.h"
 #include "SpectrumArray.h"
 #include "Metric.h"
 #include "EinsteinHelper.h"
@@ -61,6 +62,9 @@
 class Transport;
 class SpectrumArray;
 
+// components of Grid::eas_opac
+const size_t iabs=0, iscat=1, iinelastic=2;
+
 class Grid
 {
 
@@ -89,16 +93,15 @@ public:
 	vector<Axis> xAxes;
 
 	// vectors over neutrino species
-	vector<ScalarMultiDArray<double,NDIMS+1> > abs_opac;  // 1/cm
-	vector<ScalarMultiDArray<double,NDIMS+1> > scat_opac; // 1/cm, use the TRANSPORT opacity
-	vector<vector<ScalarMultiDArray<float,NDIMS+1> > > scattering_delta; // phi1/phi0 for sampling outgoing direction [s][Eout](Ein)
-	vector<ScalarMultiDArray<double,NDIMS+1> > inelastic_scat_opac; // 1/cm
-	vector<vector<ScalarMultiDArray<float,NDIMS+1> > > partial_scat_opac; // opacity integrated over outgoing frequency bin (1/cm) [s][Eout](Ein)
+	vector<MultiDArray<real,3,NDIMS+1> > eas_opac; // {abs, scat, inelastic scat} (1/cm) stored together so one interpolation gets all three. scat is the TRANSPORT opacity. Empty for species with analytic_opacities
+	vector<ScatteringKernel> scattering_kernel; // inelastic scattering opacity into each outgoing bin and its anisotropy [s], rows indexed like eas_opac[s]
+	vector<Tuple<double,3> > eas_fluid_state; // (rho,T,Ye) each zone's opacities were last computed with
 	vector<PolarSpectrumArray<0> > spectrum;
 	vector<SpectrumArray*> distribution;  // radiation energy density for each species in lab frame (erg/ccm. Integrated over bin frequency and direction)
 
 	ScalarMultiDArray<double,NDIMS> munue; // chemical potential (erg)
-	ScalarMultiDArray<double,NDIMS> lapse;
+	ScalarMultiDArray<double,NDIMS> mue;   // electron chemical potential (erg)
+	ScalarMultiDArray<real,NDIMS> lapse;
 	ScalarMultiDArray<double,NDIMS> rho;       // density (g/cm^3)
 	ScalarMultiDArray<double,NDIMS> T;         // gas temperature (K)
 	ScalarMultiDArray<double,NDIMS> Ye;        // electron fraction
@@ -114,6 +117,8 @@ public:
 	// write out zone information
 	void write_zones(const int iw);
 	void read_zones(string filename);
+	void write_opacity_cache(const string filename, const unsigned long long key) const;
+	bool read_opacity_cache(const string filename, const unsigned long long key);
 	virtual void write_child_zones(H5::H5File file) =0;
 	virtual void  read_child_zones(H5::H5File file) =0;
 
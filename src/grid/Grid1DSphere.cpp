@@ -324,9 +324,7 @@ Tuple<double,4> Grid1DSphere::sample_in_zone(int z_ind, ThreadRNG* rangen) const
 	PRINT_ASSERT(z_ind,<,(int)rho.size());
 
 	double rand[3];
-	rand[0] = rangen->uniform();
-	rand[1] = rangen->uniform();
-	rand[2] = rangen->uniform();
+	rangen->uniform_batch(rand,3);
 
 	// inner and outer radii of shell
 	double r0 = (z_ind==0 ? xAxes[0].min : xAxes[0].top[z_ind-1]);
@@ -387,13 +385,7 @@ void Grid1DSphere::symmetry_boundaries(EinsteinHelper *eh) const{
 		for(int i=0; i<3; i++) kr += eh->xup[i]/R * eh->kup[i];
 
 		// give the particle an inward-moving direction
-		Tuple<double,4> kup_tet = eh->kup_tet;
-		double costheta;
-		do{
-			sim->isotropic_kup_tet(kup_tet,&sim->rangen);
-			eh->set_kup_tet(kup_tet);
-			costheta = eh->g.dot<3>(eh->xup, eh->kup) / sqrt(eh->g.dot<3>(eh->xup, eh->xup) * eh->g.dot<3>(eh->kup, eh->kup));
-		} while(sim->reject_direction(costheta, -2.));
+		sim->sample_radial_kup_tet(eh, -2.);
 		//eh->g.normalize_null_preservedownt(eh->kup);
 
 		// put the particle just inside the boundary
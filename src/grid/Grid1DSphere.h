@@ -43,7 +43,8 @@ protected:
 	int reflect_outer;
 
 	// ds^2 = -alpha dt^2 + X^2 dr^2 + dOmega^2
-	ScalarMultiDArray<double,NDIMS> X, vr;
+	ScalarMultiDArray<real,NDIMS> X;
+	ScalarMultiDArray<double,NDIMS> vr;
 
 public:
 
@@ -1002,9 +1002,7 @@ Tuple<double,4> Grid2DSphere::sample_in_zone(int z_ind, ThreadRNG* rangen) const
 	PRINT_ASSERT(z_ind,<,(int)rho.size());
 
 	double rand[3];
-	rand[0] = rangen->uniform();
-	rand[1] = rangen->uniform();
-	rand[2] = rangen->uniform();
+	rangen->uniform_batch(rand,3);
 
 	// radius and theta indices
 	Tuple<size_t,NDIMS> dir_ind = zone_directional_indices(z_ind);
@@ -46,6 +46,7 @@ Grid3DCart::Grid3DCart(){
 	rotate_hemisphere[0] = 0;
 	rotate_hemisphere[1] = 0;
 	rotate_quadrant = 0;
+	precompute_christoffel = 0;
 	tetrad_rotation = cartesian;
 }
 
@@ -62,6 +63,7 @@ void Grid3DCart::read_child_zones(H5::H5File file){
 		betaup.read_HDF5(file,"shiftup",xAxes);
 		g3.read_HDF5(file,"threemetric",xAxes);
 		sqrtdetg3.read_HDF5(file,"sqrtdetg3",xAxes);
+		if(precompute_christoffel) set_node_Christoffel();
 	}
 	v.read_HDF5(file,"threevelocity(cm|s)",xAxes);
 }
@@ -88,6 +90,9 @@ void Grid3DCart::read_model_file(Lua* lua)
 			g.update();
 			sqrtdetg3[z_ind] = sqrt(g.gammalow.det());
 		}
+
+		precompute_christoffel = lua->scalar<int>("Grid3DCart_precompute_christoffel");
+		if(precompute_christoffel) set_node_Christoffel();
 	}
 
 	if(rotate_quadrant!=0 || rotate_hemisphere[0]!=0 || rotate_hemisphere[1]!=0){
@@ -466,9 +471,7 @@ Tuple<double,4> Grid3DCart::sample_in_zone(int z_ind, ThreadRNG* rangen) const
 	PRINT_ASSERT(z_ind,<,(int)rho.size());
 
 	double rand[3];
-	rand[0] = rangen->uniform();
-	rand[1] = rangen->uniform();
-	rand[2] = rangen->uniform();
+	rangen->uniform_batch(rand,3);
 
 	// zone directional indices
 	Tuple<size_t,NDIMS> dir_ind = zone_directional_indices(z_ind);
@@ -707,19 +710,85 @@ double Grid3DCart::zone_lorentz_factor(int z_ind) const{
 	return result;
 }
 
+//------------------------------------------------------------
+// Compute the Christoffel symbols at every grid node from
+// centered differences of the metric (one-sided at the edges),
+// so particles only need to interpolate them.
+//------------------------------------------------------------
+void Grid3DCart::set_node_Christoffel(){
+	christoffel.set_axes(xAxes);
+
+	#pragma omp parallel for
+	for(size_t z_ind=0; z_ind<lapse.size(); z_ind++){
+		Metric g;
+		g.alpha = lapse[z_ind];
+		for(size_t i=0; i<3; i++) g.betaup[i] = betaup[z_ind][i];
+		g.gammalow.data = g3[z_ind];
+		g.update();
+
+		size_t dir_ind[NDIMS];
+		lapse.indices(z_ind,dir_ind);
+		Tuple<Tuple<double,6>,NDIMS> dg3_dx;
+		Tuple<double,NDIMS> da_dx;
+		Tuple<Tuple<double,3>,NDIMS> dbetaup_dx;
+		for(size_t d=0; d<NDIMS; d++){
+			size_t left[NDIMS], right[NDIMS];
+			for(size_t i=0; i<NDIMS; i++) left[i] = right[i] = dir_ind[i];
+			if(dir_ind[d] > 0) left[d]--;
+			if(dir_ind[d] < xAxes[d].size()-1) right[d]++;
+			if(left[d]==right[d]){ // single zone in this direction
+				dg3_dx[d] = 0;
+				da_dx[d] = 0;
+				dbetaup_dx[d] = 0;
+				continue;
+			}
+			const size_t iL = lapse.direct_index(left);
+			const size_t iR = lapse.direct_index(right);
+			const double inv_dx = 1. / (xAxes[d].mid[right[d]] - xAxes[d].mid[left[d]]);
+			dg3_dx[d] = (g3[iR] - g3[iL]) * inv_dx;
+			da_dx[d] = (lapse[iR] - lapse[iL]) * inv_dx;
+			dbetaup_dx[d] = (betaup[iR] - betaup[iL]) * inv_dx;
+		}
+
+		christoffel[z_ind] = Christoffel_from_slopes(g, dg3_dx, da_dx, dbetaup_dx).data;
+	}
+
+	int MPI_myID;
+	MPI_Comm_rank( MPI_COMM_WORLD, &MPI_myID );
+	if(MPI_myID==0){
+		const double MB = 1024.*1024.;
+		cout << "#   Precomputed Christoffel symbols on " << christoffel.size() << " nodes: "
+				<< christoffel.size()*40*sizeof(real)/MB << " MB (metric itself uses "
+				<< lapse.size()*11*sizeof(real)/MB << " MB in 11 values per node)" << endl;
+	}
+}
+
 Christoffel Grid3DCart::interpolate_Christoffel(const EinsteinHelper& eh) const{
+  Christoffel ch;
+  if(precompute_christoffel){
+    ch.data = christoffel.interpolate(eh.icube_vol);
+    return ch;
+  }
+
+  Tuple<Tuple<double,6>,NDIMS> dg3_dx = g3.interpolate_slopes(eh.icube_vol);
+  Tuple<double,NDIMS> da_dx = lapse.interpolate_slopes(eh.icube_vol);
+  Tuple<Tuple<double,3>,NDIMS> dbetaup_dx = betaup.interpolate_slopes(eh.icube_vol);
+  return Christoffel_from_slopes(eh.g, dg3_dx, da_dx, dbetaup_dx);
+}
+
+// Gamma^a_mu_nu from the metric and its spatial derivatives (no time derivatives)
+Christoffel Grid3DCart::Christoffel_from_slopes(const Metric& g,
+		const Tuple<Tuple<double,6>,NDIMS>& dg3_dx,
+		const Tuple<double,NDIMS>& da_dx,
+		const Tuple<Tuple<double,3>,NDIMS>& dbetaup_dx){
   double dg[4][4][4];
   for(size_t i=0; i<4; i++) for(size_t j=0; j<4; j++){ // no time derivatives
       dg[3][i][j] = 0;
     }
 
-  Tuple<Tuple<double,6>,NDIMS> dg3_dx = g3.interpolate_slopes(eh.icube_vol);
-  Tuple<double,NDIMS> da_dx = lapse.interpolate_slopes(eh.icube_vol);
-  Tuple<Tuple<double,3>,NDIMS> dbetaup_dx = betaup.interpolate_slopes(eh.icube_vol);
   Tuple<Tuple<double,3>,NDIMS> dbetalow_dx;
-
   for(size_t a=0; a<3; a++) 
-    dbetalow_dx[a] = eh.g.gammalow.lower(dbetaup_dx[a]);
+    dbetalow_dx[a] = g.gammalow.lower(dbetaup_dx[a]);
   
   #pragma omp simd
   for(size_t a=0; a<3; a++){
@@ -739,9 +808,9 @@ Christoffel Grid3DCart::interpolate_Christoffel(const EinsteinHelper& eh) const{
     dg[a][3][0] = dbetalow_dx[a][0];
     dg[a][3][1] = dbetalow_dx[a][1];
     dg[a][3][2] = dbetalow_dx[a][2];
-    dg[a][3][3] = -eh.g.alpha * da_dx[a];
+    dg[a][3][3] = -g.alpha * da_dx[a];
     for(size_t i=0; i<3; i++)
-      dg[a][3][3] += eh.g.betalow[i] * dbetaup_dx[a][i]; // [direction][element]
+      dg[a][3][3] += g.betalow[i] * dbetaup_dx[a][i]; // [direction][element]
     dg[a][3][3] *= 2.;
   }
 
@@ -749,7 +818,7 @@ Christoffel Grid3DCart::interpolate_Christoffel(const EinsteinHelper& eh) const{
   ch.data = 0;
   for(size_t a=0; a<4; a++){
 	  for(size_t b=0; b<4; b++){
-		  double gupab = eh.g.get_inverse(a,b);
+		  double gupab = g.get_inverse(a,b);
 		  for(size_t mu=0; mu<4; mu++){
 			  for(size_t nu=mu; nu<4; nu++){ // yes, intentionally only go from mu to 4
 				  ch.data[Christoffel::index(a,mu,nu)] += 0.5 * gupab * (dg[mu][b][nu] + dg[nu][mu][b] - dg[b][mu][nu]);
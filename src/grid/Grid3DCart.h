@@ -35,6 +35,7 @@
 //    Grid3DCart_reflect_{x,y,z} -- reflect particles off the {x,y,z}=0 boundary. Also truncates the fluid grid there.
 //    Grid3DCart_rotate_hemisphere_{x,y} -- assume 180-degree rotational symmetry in hemispheres where everywhere {x,y}>0
 //    Grid3DCart_rotate_quadrant -- assume 90-degree rotational symmetry. x and y >0 everywhere.
+//    Grid3DCart_precompute_christoffel -- compute the Christoffel symbols once on the grid nodes and interpolate them
 
 //*******************************************
 // 1-Dimensional Spherical geometry
@@ -49,9 +50,18 @@ private:
 	int    rotate_hemisphere[2];
 	int    rotate_quadrant;
 
-	MultiDArray<double,3,NDIMS> betaup; // shift
-	MultiDArray<double,6,NDIMS> g3;  // three-metric
-	ScalarMultiDArray<double,NDIMS> sqrtdetg3; // sqrt of determinant of three-metric
+	MultiDArray<real,3,NDIMS> betaup; // shift
+	MultiDArray<real,6,NDIMS> g3;  // three-metric
+	ScalarMultiDArray<real,NDIMS> sqrtdetg3; // sqrt of determinant of three-metric
+
+	// Christoffel symbols on the grid nodes (only if precompute_christoffel)
+	int precompute_christoffel;
+	MultiDArray<real,40,NDIMS> christoffel;
+	void set_node_Christoffel();
+	static Christoffel Christoffel_from_slopes(const Metric& g,
+			const Tuple<Tuple<double,6>,NDIMS>& dg3_dx,
+			const Tuple<double,NDIMS>& da_dx,
+			const Tuple<Tuple<double,3>,NDIMS>& dbetaup_dx);
 
 	MultiDArray<double,3,NDIMS> v;
 
@@ -6,6 +6,7 @@
 #include "global_options.h"
 #include "hdf5.h"
 #include <string>
+#include <cmath>
 
 using namespace std;
 
@@ -18,6 +19,11 @@ public:
 	vector<double> top;
 	vector<double> mid;
 
+	// regularly spaced axes find bins arithmetically rather than by binary search
+	enum Spacing {irregular_spacing, uniform_spacing, log_spacing};
+	Spacing spacing;
+	double inv_delta; // 1/(bin width) in x or in log(x)
+
 	Axis(const double min, vector<double>& top, vector<double>& mid){
 		PRINT_ASSERT(top.size(),==,mid.size());
 		this->min = min;
@@ -27,6 +33,7 @@ public:
 			PRINT_ASSERT(top[i],>,mid[i]);
 			PRINT_ASSERT(mid[i],>, ((i==0) ? min : top[i-1]));
 		}
+		set_spacing();
 	}
 	Axis(const double min, const double max, const size_t nbins){
 		this->min = min;
@@ -37,10 +44,41 @@ public:
 			top[i] = min + (i+1)*del;
 			mid[i] = min + ((double)i + 0.5)*del;
 		}
+		set_spacing();
 	}
 
 	Axis() {
 		min = NaN;
+		spacing = irregular_spacing;
+		inv_delta = NaN;
+	}
+
+	// check whether the bin tops are uniform in x or in log(x)
+	void set_spacing(){
+		spacing = irregular_spacing;
+		inv_delta = NaN;
+		const size_t n = top.size();
+		if(n==0) return;
+
+		const double del = (top[n-1] - min) / (double)n;
+		bool is_uniform = del>0;
+		for(size_t i=0; i<n && is_uniform; i++)
+			is_uniform = abs(top[i] - (min + (i+1)*del)) <= TINY*del;
+		if(is_uniform){
+			spacing = uniform_spacing;
+			inv_delta = 1./del;
+			return;
+		}
+
+		if(min<=0) return;
+		const double logdel = log(top[n-1]/min) / (double)n;
+		bool is_log = logdel>0;
+		for(size_t i=0; i<n && is_log; i++)
+			is_log = abs(log(top[i]/min) - (i+1)*logdel) <= TINY*logdel;
+		if(is_log){
+			spacing = log_spacing;
+			inv_delta = 1./logdel;
+		}
 	}
 
 	size_t size() const {
@@ -50,7 +88,7 @@ public:
 
 	int bin(const double x) const{
 		if(x<min) return -1;
-		else{
+		else if(spacing==irregular_spacing){
 			// upper_bound returns first element greater than xval
 			// values mark bin tops, so this is what we want
 			int ind = upper_bound(top.begin(), top.end(), x) - top.begin();
@@ -58,6 +96,18 @@ public:
 			PRINT_ASSERT(ind,<=,(int)top.size());
 			return ind;
 		}
+		else{
+			// guess the bin, then fix any roundoff so the result
+			// is the same as the binary search
+			const int n = top.size();
+			const double f = (spacing==uniform_spacing ? (x-min) : log(x/min)) * inv_delta;
+			int ind = (f<n ? (int)f : n);
+			while(ind>0 && x<top[ind-1]) ind--;
+			while(ind<n && x>=top[ind]) ind++;
+			PRINT_ASSERT(ind,>=,0);
+			PRINT_ASSERT(ind,<=,n);
+			return ind;
+		}
 	}
 
 	double bottom(const size_t i) const{
@@ -127,6 +177,7 @@ public:
 		dataset.close();
 
 		PRINT_ASSERT(mid.size(),==,top.size());
+		set_spacing();
 	}
 };
 
@@ -6,57 +6,92 @@
 #include "Metric.h"
 #include "physical_constants.h"
 #include "MultiDArray.h"
+#include "ThreadRNG.h"
 
 namespace pc = physical_constants;
 using namespace std;
 
 enum TetradRotation {cartesian, spherical};
 
-class EinsteinHelper{
+//----------------------------------------------------------
+// The particle state carried from step to step: position,
+// momentum, weight, indices, and the step's opacity. This is
+// all Transport::move() needs to snapshot.
+//----------------------------------------------------------
+class EinsteinState{
 public:
-	// essential variables interpolated from grid
 	Tuple<double,4> xup;
 	Tuple<double,4> kup, kup_tet; // erg
-	Tuple<double,4> u; // dimensionless, up index
-	Tuple<double,3> v; // cm/s
 	double N;
 	size_t s;
+	size_t id;
 	ParticleFate fate;
 	double N0;
-	Metric g;
-	Christoffel Gamma;
-	double zone_fourvolume;
+	uint32_t split_label; // phase of the propagation stream. 1, plus one hex digit per weight window split
 
-	// things with which to do interpolation
-	InterpolationCube<NDIMS  > icube_vol; // for metric quantities
-	InterpolationCube<NDIMS+1> icube_spec; // for eas
-
-	// intermediate quantities
-	Tuple<double,4> e[4]; // [tet(low)][coord(up)]
-	double grid_coords[NDIMS+1];
-	double absopac, scatopac, inelastic_scatopac;
+	double absopac;
 	double ds_com;
+	double zone_fourvolume;
+	double dlambda_geodesic; // last step suggested by the adaptive geodesic integrator
 	size_t dir_ind[NDIMS+1]; // spatial, nu_in
 	int z_ind, eas_ind;   // direct access indices
 
- EinsteinHelper() :
+ EinsteinState() :
 	xup(NaN),
 	  kup(NaN),
 	  kup_tet(NaN),
-	  u(NaN),
-	  v(NaN),
 	  N(NaN),
 	  s(-MAXLIM),
+	  id(-MAXLIM),
 	  fate(moving),
 	  N0(NaN),
-	  zone_fourvolume(NaN),
-	  e{NaN,NaN,NaN,NaN},
+	  split_label(1),
 	  absopac(NaN),
-	  scatopac(NaN),
 	  ds_com(NaN),
+	  zone_fourvolume(NaN),
+	  dlambda_geodesic(NaN),
 	  z_ind(-MAXLIM),
-	  eas_ind(-MAXLIM),
+	  eas_ind(-MAXLIM) {}
+};
+
+//----------------------------------------------------------
+// Background quantities at the particle's position. They are
+// recomputed from the state by update_eh_background() and
+// update_eh_k_opac(), so they never need to be saved.
+//----------------------------------------------------------
+class EinsteinBackground{
+public:
+	Tuple<double,4> u; // dimensionless, up index
+	Tuple<double,3> v; // cm/s
+	Metric g;
+	Christoffel Gamma;
+
+	// things with which to do interpolation
+	InterpolationCube<NDIMS  > icube_vol; // for metric quantities
+	InterpolationCube<NDIMS+1> icube_spec; // for eas
+
+	// intermediate quantities
+	Tuple<double,4> e[4]; // [tet(low)][coord(up)]
+	double grid_coords[NDIMS+1];
+	double scatopac, inelastic_scatopac;
+
+ EinsteinBackground() :
+	u(NaN),
+	  v(NaN),
+	  e{NaN,NaN,NaN,NaN},
+	  scatopac(NaN),
 	  inelastic_scatopac(NaN) {}
+};
+
+class EinsteinHelper : public EinsteinState, public EinsteinBackground{
+public:
+	RandomStream rng;
+
+	// start a new particle. The background is left as is, since
+	// update_eh_background() overwrites it before it is used.
+	void reset(){
+		EinsteinState::operator=(EinsteinState());
+	}
 
 	void set_kup_tet(const Tuple<double,4>& kup_tet_in){
 		PRINT_ASSERT(Metric::dot_Minkowski<4>(kup_tet_in,kup_tet_in)/(kup_tet_in[3]*kup_tet_in[3]),<,TINY);
@@ -216,6 +251,7 @@ public:
 		}
 		pout.N = N;
 		pout.s = s;
+		pout.id = id;
 		pout.fate = fate;
 		return pout;
 	}
@@ -226,6 +262,7 @@ public:
 		}
 		N = pin.N;
 		s = pin.s;
+		id = pin.id;
 		fate = pin.fate;
 	}
 };
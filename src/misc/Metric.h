@@ -2,7 +2,6 @@
 #define _METRIC_H 1
 
 #include "global_options.h"
-#include "gsl/gsl_linalg.h"
 
 const size_t ixx=0,iyy=1,izz=2,ixy=3,ixz=4,iyz=5,itt=6,ixt=7,iyt=8,izt=9;
 
@@ -49,29 +48,21 @@ public:
 	  out[2] = in[0]*data[ixz] + in[1]*data[iyz] + in[2]*data[izz];
 	  return out;
 	}
+	// closed-form symmetric inverse (adjugate / determinant)
 	ThreeMetric inverse() const{
-		gsl_matrix* g = gsl_matrix_alloc(3,3);
-		for(size_t i=0; i<3; i++)
-		  for(size_t j=0; j<3; j++)
-		    gsl_matrix_set(g,i,j, data[index(i,j)]);
-
-		// invert and store
-		gsl_linalg_cholesky_decomp(g);
-		gsl_linalg_cholesky_invert(g);
 		ThreeMetric output;
-		output.data[ixx] = gsl_matrix_get(g, 0, 0);
-		output.data[ixy] = gsl_matrix_get(g, 0, 1);
-		output.data[ixz] = gsl_matrix_get(g, 0, 2);
-		output.data[iyy] = gsl_matrix_get(g, 1, 1);
-		output.data[iyz] = gsl_matrix_get(g, 1, 2);
-		output.data[izz] = gsl_matrix_get(g, 2, 2);
-
-		// free the memory
-		gsl_matrix_free(g);
-
+		output.data[ixx] = data[iyy]*data[izz] - data[iyz]*data[iyz];
+		output.data[ixy] = data[ixz]*data[iyz] - data[ixy]*data[izz];
+		output.data[ixz] = data[ixy]*data[iyz] - data[iyy]*data[ixz];
+		output.data[iyy] = data[ixx]*data[izz] - data[ixz]*data[ixz];
+		output.data[iyz] = data[ixy]*data[ixz] - data[ixx]*data[iyz];
+		output.data[izz] = data[ixx]*data[iyy] - data[ixy]*data[ixy];
+
+		const double invdet = 1. / (data[ixx]*output.data[ixx] + data[ixy]*output.data[ixy] + data[ixz]*output.data[ixz]);
+		PRINT_ASSERT(invdet,>,0);
+		for(size_t i=0; i<6; i++) output.data[i] *= invdet;
 		return output;
 	}
-
 	inline double get(const size_t i, const size_t j) const{
 		return data[index(i,j)];
 	}
@@ -141,12 +132,17 @@ public:
 	template<size_t n, size_t n1>
 	Tuple<double,n> lower(const Tuple<double,n1>& xup) const{
 		PRINT_ASSERT(n,<=,n1);
+		PRINT_ASSERT(n,>=,3);
 		Tuple<double,n> xdown;
 		if(DO_GR){
-			for(size_t i=0; i<n; i++){
-				xdown[i] = 0;
-				for(size_t j=0; j<n; j++)
-					xdown[i] += xup[j] * get(i,j);
+			// x_i = gamma_ij x^j + beta_i x^t,  x_t = beta_j x^j + gtt x^t
+			Tuple<double,3> x3;
+			for(size_t i=0; i<3; i++) x3[i] = xup[i];
+			const Tuple<double,3> g3x = gammalow.lower(x3);
+			for(size_t i=0; i<3; i++) xdown[i] = g3x[i];
+			if(n==4){
+				for(size_t i=0; i<3; i++) xdown[i] += betalow[i] * xup[3];
+				xdown[3] = contract<3>(betalow,xup) + gtt * xup[3];
 			}
 		}
 		else{
@@ -158,13 +154,16 @@ public:
 
 	template<size_t n>
 	Tuple<double,n> raise(const Tuple<double,n>& xdown) const{
+		PRINT_ASSERT(n,>=,3);
 	        Tuple<double,n> xup;
 		if(DO_GR){
-			for(size_t i=0; i<n; i++){
-				xup[i] = 0;
-				for(size_t j=0; j<n; j++)
-					xup[i] += xdown[j] * get_inverse(i,j);
-			}
+			// x^i = gamma^ij x_j + beta^i (x_t - beta^j x_j)/alpha^2,  x^t = -(x_t - beta^j x_j)/alpha^2
+			Tuple<double,3> x3;
+			for(size_t i=0; i<3; i++) x3[i] = xdown[i];
+			const Tuple<double,3> g3x = gammaup.lower(x3); // same contraction with the inverse
+			const double lapse_part = ((n==4 ? xdown[3] : 0) - contract<3>(betaup,xdown)) / (alpha*alpha);
+			for(size_t i=0; i<3; i++) xup[i] = g3x[i] + betaup[i] * lapse_part;
+			if(n==4) xup[3] = -lapse_part;
 		}
 		else{
 			for(size_t i=0; i<3; i++) xup[i] = xdown[i];
@@ -336,12 +335,27 @@ public:
 
 	Christoffel() : data(NaN) {}
 
+	// Gamma^a_ij k^i k^j. The symmetric products are formed once in
+	// the same ordering as the data, so each component is a plain
+	// 10-element dot product.
 	Tuple<double,4> contract2(const Tuple<double,4>& kup) const{
-		Tuple<double,4> result = 0;
+		double kk[10];
+		kk[ixx] =    kup[0]*kup[0];
+		kk[iyy] =    kup[1]*kup[1];
+		kk[izz] =    kup[2]*kup[2];
+		kk[ixy] = 2.*kup[0]*kup[1];
+		kk[ixz] = 2.*kup[0]*kup[2];
+		kk[iyz] = 2.*kup[1]*kup[2];
+		kk[itt] =    kup[3]*kup[3];
+		kk[ixt] = 2.*kup[0]*kup[3];
+		kk[iyt] = 2.*kup[1]*kup[3];
+		kk[izt] = 2.*kup[2]*kup[3];
+
+		Tuple<double,4> result;
 		for(size_t a=0; a<4; a++){
-			for(size_t i=0; i<4; i++)
-				for(size_t j=0; j<4; j++)
-					result[a] += data[index(a,i,j)] * kup[i]*kup[j];
+			double sum = 0;
+			for(size_t m=0; m<10; m++) sum += data[10*a + m] * kk[m];
+			result[a] = sum;
 		}
 		return result;
 	}
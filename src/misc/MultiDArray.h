@@ -8,6 +8,24 @@
 
 using namespace std;
 
+//========//
+// Unroll //
+//========//
+// calls f(0), f(1), ..., f(n-1) with the loop unrolled at compile time
+template<size_t n>
+struct Unroll{
+	template<typename F>
+	static inline void run(F& f){
+		Unroll<n-1>::run(f);
+		f(n-1);
+	}
+};
+template<>
+struct Unroll<0>{
+	template<typename F>
+	static inline void run(F&){}
+};
+
 //===================//
 // InterpolationCube //
 //===================//
@@ -53,28 +71,21 @@ public:
 	}
 
 	void set_weights(const double x[ndims]){
-
-		// total volume
-		double V=1;
-		for(size_t d=0; d<ndims; d++){
-			double dx = xLR[d][1] - xLR[d][0];
-			V *= dx;
-		}
-		double sumweights=0;
-		for(size_t i=0; i<ncorners; i++){
-
-			// volume/area associated with each point/line
-			double dVol=1;
-			for(size_t d=0; d<ndims; d++){
-				size_t LR = not isRightIndex(i,d); // 1 if left, 0 if right
-				double dx = x[d] - xLR[d][LR];
-				dVol *= dx;
+		// build the corner weights one dimension at a time. The corners
+		// already set get split into a left (1-f) and right (f) copy.
+		weights[0] = 1;
+		auto split_dimension = [&](const size_t d){
+			const double f = (x[d] - xLR[d][0]) / (xLR[d][1] - xLR[d][0]);
+			const size_t n = 1<<d;
+			for(size_t i=0; i<n; i++){
+				weights[i+n] = weights[i] * f;
+				weights[i] *= 1.-f;
 			}
+		};
+		Unroll<ndims>::run(split_dimension);
 
-			// weights
-			weights[i] = abs(dVol/V); // avoids if statement in above loop for sign
-			sumweights += weights[i];
-		}
+		double sumweights=0;
+		for(size_t i=0; i<ncorners; i++) sumweights += weights[i];
 		PRINT_ASSERT(abs(1.-sumweights),<,TINY);
 	}
 
@@ -110,6 +121,23 @@ public:
 };
 
 
+//=============//
+// StorageType //
+//=============//
+// MPI and HDF5 memory types of the stored values. ATOMIC<double>
+// tallies have the layout of a double.
+template<typename T>
+struct StorageType{
+	static MPI_Datatype mpi(){return MPI_DOUBLE;}
+	static const H5::PredType& h5(){return H5::PredType::NATIVE_DOUBLE;}
+};
+template<>
+struct StorageType<float>{
+	static MPI_Datatype mpi(){return MPI_FLOAT;}
+	static const H5::PredType& h5(){return H5::PredType::NATIVE_FLOAT;}
+};
+
+
 //=============//
 // MultiDArray //
 //=============//
@@ -122,6 +150,7 @@ public:
 	Tuple<size_t,ndims> stride;
 
 	MultiDArray(){}
+	MultiDArray(const MultiDArray&) = default;
 
 	void set_axes(const vector<Axis>& axes){
 		this->axes = axes;
@@ -187,32 +216,36 @@ public:
 	}
 
 	// dummy template allows it to compile with any value of NDIMS
+	// the sum is always done in double, whatever the storage type
 	template<size_t dummy>
-	Tuple<T,nelements> interpolate(const InterpolationCube<dummy>& icube) const{
+	Tuple<double,nelements> interpolate(const InterpolationCube<dummy>& icube) const{
 		PRINT_ASSERT(icube.ncorners,==,(1<<ndims));
 
-		Tuple<T,nelements> result(0);
-		for(size_t i=0; i<icube.ncorners; i++){
+		Tuple<double,nelements> result(0);
+		auto add_corner = [&](const size_t i){
 			PRINT_ASSERT(icube.indices[i],>=,0);
 			PRINT_ASSERT(icube.indices[i],<,size());
 			PRINT_ASSERT(icube.weights[i],<=,1.0);
 			PRINT_ASSERT(icube.weights[i],>=,0.0);
-			result += y0[icube.indices[i]] * icube.weights[i];
-		}
+			const Tuple<T,nelements>& y = y0[icube.indices[i]];
+			for(size_t e=0; e<nelements; e++) result[e] += y[e] * icube.weights[i];
+		};
+		Unroll<InterpolationCube<dummy>::ncorners>::run(add_corner);
 		return result;
 	}
 
 	// dummy template allows it to compile with any value of NDIMS
 	template<size_t dummy>
-	Tuple<Tuple<T,nelements>,ndims> interpolate_slopes(const InterpolationCube<dummy>& icube) const{
+	Tuple<Tuple<double,nelements>,ndims> interpolate_slopes(const InterpolationCube<dummy>& icube) const{
 		PRINT_ASSERT(icube.ncorners,==,(1<<ndims));
 
-		Tuple<Tuple<T,nelements>,ndims> result;
+		Tuple<Tuple<double,nelements>,ndims> result;
 		for(size_t d=0; d<ndims; d++){
-			result[d] = y0[icube.indices[0]] * icube.slope_weights[d][0];;
-			for(size_t i=1; i<icube.ncorners; i++){
+			result[d] = 0;
+			for(size_t i=0; i<icube.ncorners; i++){
 				PRINT_ASSERT(icube.indices[i],>=,0);
-				result[d] += y0[icube.indices[i]] * icube.slope_weights[d][i];
+				const Tuple<T,nelements>& y = y0[icube.indices[i]];
+				for(size_t e=0; e<nelements; e++) result[d][e] += y[e] * icube.slope_weights[d][i];
 			}
 		}
 		return result;
@@ -323,9 +356,9 @@ public:
 			const size_t istart = (p==0 ? 0 : stop_list[p-1]);
 			const size_t ndoubles = (stop_list[p]-istart) * nelements;
 			if(MPI_myID==p)
-				MPI_Reduce(MPI_IN_PLACE, &y0[istart], ndoubles, MPI_DOUBLE, MPI_SUM, p, MPI_COMM_WORLD);
+				MPI_Reduce(MPI_IN_PLACE, &y0[istart], ndoubles, StorageType<T>::mpi(), MPI_SUM, p, MPI_COMM_WORLD);
 			else
-				MPI_Reduce(&y0[istart],         NULL, ndoubles, MPI_DOUBLE, MPI_SUM, p, MPI_COMM_WORLD);
+				MPI_Reduce(&y0[istart],         NULL, ndoubles, StorageType<T>::mpi(), MPI_SUM, p, MPI_COMM_WORLD);
 		}
 
 		// and bring everything to proc0 as well
@@ -336,9 +369,14 @@ public:
 		int MPI_myID;
 		MPI_Comm_rank(MPI_COMM_WORLD, &MPI_myID);
 		if(MPI_myID==0)
-			MPI_Reduce(MPI_IN_PLACE, &y0.front(), y0.size()*nelements, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+			MPI_Reduce(MPI_IN_PLACE, &y0.front(), y0.size()*nelements, StorageType<T>::mpi(), MPI_SUM, 0, MPI_COMM_WORLD);
 		else
-			MPI_Reduce(&y0.front(),         NULL, y0.size()*nelements, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+			MPI_Reduce(&y0.front(),         NULL, y0.size()*nelements, StorageType<T>::mpi(), MPI_SUM, 0, MPI_COMM_WORLD);
+	}
+
+	// like mpi_sum, but every rank gets the result
+	void mpi_allsum(){
+		MPI_Allreduce(MPI_IN_PLACE, &y0.front(), y0.size()*nelements, StorageType<T>::mpi(), MPI_SUM, MPI_COMM_WORLD);
 	}
 
 	void mpi_gather(vector<size_t>& stop_list){
@@ -356,9 +394,9 @@ public:
 			sendcounts[i] = stop_list[i] - stop_list[i-1];
 		}
 		if(MPI_myID==0)
-			MPI_Gatherv(MPI_IN_PLACE, -1, MPI_DOUBLE, &y0[0],&sendcounts.front(),&displs.front(), MPI_DOUBLE,0,MPI_COMM_WORLD);
+			MPI_Gatherv(MPI_IN_PLACE, -1, StorageType<T>::mpi(), &y0[0],&sendcounts.front(),&displs.front(), StorageType<T>::mpi(),0,MPI_COMM_WORLD);
 		else
-			MPI_Gatherv(&y0[displs[MPI_myID]], sendcounts[MPI_myID], MPI_DOUBLE, NULL, NULL, NULL, MPI_DOUBLE,0,MPI_COMM_WORLD);
+			MPI_Gatherv(&y0[displs[MPI_myID]], sendcounts[MPI_myID], StorageType<T>::mpi(), NULL, NULL, NULL, StorageType<T>::mpi(),0,MPI_COMM_WORLD);
 	}
 
 	void write_HDF5(H5::H5File file, const string name) {
@@ -373,9 +411,9 @@ public:
 		}
 		H5::DataSet dataset = file.createDataSet(name,H5::PredType::IEEE_F64LE,dataspace);
 
-		// write the data (converting to single precision)
+		// write the data (always double precision in the file)
 		// assumes phi increases fastest, then mu, then nu
-		dataset.write(&y0.front(), H5::PredType::IEEE_F64LE);
+		dataset.write(&y0.front(), StorageType<T>::h5());
 		dataset.close();
 	}
 	void read_HDF5(H5::H5File file, const string name, const vector<Axis>& axes_in) {
@@ -399,7 +437,7 @@ public:
 
 		// read the data
 		y0.resize(ntot);
-		dataset.read(&y0.front(), H5::PredType::IEEE_F64LE);
+		dataset.read(&y0.front(), StorageType<T>::h5());
 		dataset.close();
 	}
 };
@@ -428,15 +466,15 @@ public:
 	}
 
 	template<size_t dummy>
-	T interpolate(const InterpolationCube<dummy>& icube) const{
+	double interpolate(const InterpolationCube<dummy>& icube) const{
 		return MultiDArray<T,1,ndims>::interpolate(icube)[0];
 	}
 	template<size_t dummy>
 	Tuple<double,ndims> interpolate_slopes(const InterpolationCube<dummy>& icube) const{
-		Tuple<Tuple<T,1>,ndims> result;
+		Tuple<Tuple<double,1>,ndims> result;
 		result = MultiDArray<T,1,ndims>::interpolate_slopes(icube);
 
-		Tuple<T,ndims> return_value;
+		Tuple<double,ndims> return_value;
 		for(size_t i=0; i<ndims; i++) return_value[i] = result[i][0];
 		return return_value;
 	}
@@ -47,6 +47,7 @@ public:
 	Tuple<double, 4> kup;         // 4-wavevector (erg) //old definition:(2pi nu/c)
 	double             N;         // total number of neutrinos in packet
 	size_t           s;         // species number
+	size_t          id;         // global emission index, identifies the particle's random stream
 	ParticleFate    fate;
 };
 #endif
@@ -0,0 +1,96 @@
+/*
+//  Copyright (c) 2015, California Institute of Technology and the Regents
+//  of the University of California, based on research sponsored by the
+//  United States Department of Energy. All rights reserved.
+//
+//  This file is part of Sedonu.
+//
+//  Sedonu is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Neither the name of the California Institute of Technology (Caltech)
+//  nor the University of California nor the names of its contributors 
+//  may be used to endorse or promote products derived from this software
+//  without specific prior written permission.
+//
+//  Sedonu is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Sedonu.  If not, see <http://www.gnu.org/licenses/>.
+//
+*/
+
+#ifndef _PARTICLELIST_H
+#define _PARTICLELIST_H
+
+#include <vector>
+#include "global_options.h"
+#include "Particle.h"
+
+using namespace std;
+
+//-----------------------------------------------------------------
+// Structure-of-arrays particle store. Each particle component
+// lives in its own contiguous array so that batches of particles
+// can be loaded/stored with unit stride.
+//-----------------------------------------------------------------
+class ParticleList
+{
+
+public:
+
+	vector<double> xup[4];      // x,y,z,ct position (cm)
+	vector<double> kup[4];      // 4-wavevector (erg)
+	vector<double> N;           // total number of neutrinos in packet
+	vector<size_t> s;           // species number
+	vector<size_t> id;          // global emission index
+	vector<ParticleFate> fate;
+
+	size_t size() const{
+		return fate.size();
+	}
+
+	void resize(const size_t n){
+		for(size_t i=0; i<4; i++){
+			xup[i].resize(n);
+			kup[i].resize(n);
+		}
+		N.resize(n);
+		s.resize(n);
+		id.resize(n);
+		fate.resize(n);
+	}
+
+	Particle get(const size_t i) const{
+		PRINT_ASSERT(i,<,size());
+		Particle p;
+		for(size_t d=0; d<4; d++){
+			p.xup[d] = xup[d][i];
+			p.kup[d] = kup[d][i];
+		}
+		p.N = N[i];
+		p.s = s[i];
+		p.id = id[i];
+		p.fate = fate[i];
+		return p;
+	}
+
+	void set(const size_t i, const Particle& p){
+		PRINT_ASSERT(i,<,size());
+		for(size_t d=0; d<4; d++){
+			xup[d][i] = p.xup[d];
+			kup[d][i] = p.kup[d];
+		}
+		N[i] = p.N;
+		s[i] = p.s;
+		id[i] = p.id;
+		fate[i] = p.fate;
+	}
+};
+
+#endif
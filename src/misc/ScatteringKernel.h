@@ -0,0 +1,205 @@
+/*
+//  Copyright (c) 2015, California Institute of Technology and the Regents
+//  of the University of California, based on research sponsored by the
+//  United States Department of Energy. All rights reserved.
+//
+//  This file is part of Sedonu.
+//
+//  Sedonu is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  Neither the name of the California Institute of Technology (Caltech)
+//  nor the University of California nor the names of its contributors 
+//  may be used to endorse or promote products derived from this software
+//  without specific prior written permission.
+//
+//  Sedonu is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with Sedonu.  If not, see <http://www.gnu.org/licenses/>.
+//
+*/
+
+#ifndef _SCATTERING_KERNEL_H
+#define _SCATTERING_KERNEL_H 1
+
+#include <vector>
+#include "MultiDArray.h"
+
+//**********************************************************
+// Inelastic scattering kernel of one species.
+//
+// Each row is one (zone, incoming group) and holds the
+// opacity into each outgoing group, the anisotropy of each,
+// and a Walker alias table for sampling the outgoing group.
+// The kernels are concentrated near the diagonal, so each
+// row only keeps a band of `bandwidth` consecutive outgoing
+// groups starting at band_start[row], positioned to hold as
+// much of the row's opacity as possible. Groups outside the
+// band have zero opacity and anisotropy, and the opacity
+// they held is dropped from the row's total as well. With
+// bandwidth equal to the number of groups the kernel is
+// stored exactly.
+//**********************************************************
+class ScatteringKernel{
+
+public:
+
+	size_t ngroups, bandwidth;
+	std::vector<unsigned> band_start;        // [row] first outgoing group stored
+	std::vector<float> opac;                 // [row*bandwidth + i] opacity into group band_start+i (1/cm)
+	std::vector<float> delta;                // phi1/phi0 for sampling the outgoing direction, same indexing
+	std::vector<float> alias_prob;           // probability of keeping entry i, same indexing
+	std::vector<unsigned short> alias_index; // band entry to use instead, same indexing
+	ATOMIC<double> max_truncated_fraction;   // largest fraction of a row's opacity outside its band
+
+	ScatteringKernel(){
+		ngroups = 0;
+		bandwidth = 0;
+		max_truncated_fraction = 0;
+	}
+
+	// bandwidth<=0 stores the full kernel
+	void init(const size_t nrows, const size_t ngroups_in, const int bandwidth_in){
+		ngroups = ngroups_in;
+		bandwidth = (bandwidth_in<=0 || bandwidth_in>(int)ngroups) ? ngroups : bandwidth_in;
+		PRINT_ASSERT(bandwidth,<=,65536);
+		band_start.assign(nrows,0);
+		opac.assign(nrows*bandwidth,0);
+		delta.assign(nrows*bandwidth,0);
+		alias_prob.assign(nrows*bandwidth,1);
+		alias_index.resize(nrows*bandwidth);
+		for(size_t i=0; i<alias_index.size(); i++) alias_index[i] = i % bandwidth;
+	}
+
+	size_t size() const{
+		return band_start.size();
+	}
+
+	size_t memory_bytes() const{
+		return band_start.size()*sizeof(unsigned) + opac.size()*(3*sizeof(float) + sizeof(unsigned short));
+	}
+
+	// store one row given the full kernel. Returns the opacity summed
+	// over the band, which is what the row scatters into.
+	double set_row(const size_t row, const double* opac_full, const double* delta_full){
+		PRINT_ASSERT(row,<,size());
+
+		// slide the band to where it covers the most opacity
+		double total=0, band_sum=0, best_sum=-1;
+		size_t start = 0;
+		for(size_t g=0; g<ngroups; g++){
+			PRINT_ASSERT(opac_full[g],>=,0);
+			total += (float)opac_full[g];
+			band_sum += (float)opac_full[g];
+			if(g>=bandwidth) band_sum -= (float)opac_full[g-bandwidth];
+			if(g+1>=bandwidth && band_sum>best_sum){
+				best_sum = band_sum;
+				start = g+1-bandwidth;
+			}
+		}
+		band_start[row] = start;
+		float* o = &opac[row*bandwidth];
+		float* d = &delta[row*bandwidth];
+		band_sum = 0;
+		for(size_t i=0; i<bandwidth; i++){
+			o[i] = opac_full[start+i];
+			d[i] = delta_full[start+i];
+			band_sum += o[i];
+		}
+		set_alias(row);
+
+		// keep track of how much the band leaves out
+		const double truncated = total>0 ? (total-band_sum)/total : 0;
+		double old_max = max_truncated_fraction.load();
+		while(truncated>old_max && !max_truncated_fraction.compare_exchange_weak(old_max, truncated));
+		return band_sum;
+	}
+
+	void wipe_row(const size_t row){
+		band_start[row] = 0;
+		for(size_t i=row*bandwidth; i<(row+1)*bandwidth; i++){
+			opac[i] = delta[i] = 0;
+			alias_prob[i] = 1;
+			alias_index[i] = i - row*bandwidth;
+		}
+	}
+
+	// Walker alias table over the band. Entry i is picked with
+	// probability prob[i]/bandwidth and otherwise redirects to
+	// index[i], so sampling costs one random number. An empty
+	// row is never sampled.
+	void set_alias(const size_t row){
+		const float* o = &opac[row*bandwidth];
+		float* prob = &alias_prob[row*bandwidth];
+		unsigned short* index = &alias_index[row*bandwidth];
+		std::vector<double> q(bandwidth);
+		std::vector<size_t> small(bandwidth), large(bandwidth);
+
+		// scaled probabilities
+		double total = 0;
+		for(size_t i=0; i<bandwidth; i++) total += o[i];
+		size_t nsmall=0, nlarge=0;
+		for(size_t i=0; i<bandwidth; i++){
+			q[i] = total>0 ? o[i] * bandwidth / total : 1.;
+			if(q[i] < 1.) small[nsmall++] = i;
+			else          large[nlarge++] = i;
+		}
+
+		// pair each underfull entry with an overfull one
+		while(nsmall>0 and nlarge>0){
+			const size_t l = small[--nsmall];
+			const size_t g = large[--nlarge];
+			prob[l] = q[l];
+			index[l] = g;
+			q[g] -= 1. - q[l];
+			if(q[g] < 1.) small[nsmall++] = g;
+			else          large[nlarge++] = g;
+		}
+
+		// whatever is left is full up to roundoff
+		while(nlarge>0){
+			const size_t g = large[--nlarge];
+			prob[g] = 1;
+			index[g] = g;
+		}
+		while(nsmall>0){
+			const size_t l = small[--nsmall];
+			prob[l] = 1;
+			index[l] = l;
+		}
+	}
+
+	// outgoing group from a uniform random number in [0,1)
+	size_t sample(const size_t row, const double U) const{
+		const double V = U * bandwidth;
+		size_t i = std::min((size_t)V, bandwidth-1);
+		if(V-i >= alias_prob[row*bandwidth+i]) i = alias_index[row*bandwidth+i];
+		return band_start[row] + i;
+	}
+
+	float get_opac(const size_t row, const size_t igout) const{
+		const size_t i = igout - band_start[row];
+		return (igout>=band_start[row] && i<bandwidth) ? opac[row*bandwidth+i] : 0;
+	}
+	float get_delta(const size_t row, const size_t igout) const{
+		const size_t i = igout - band_start[row];
+		return (igout>=band_start[row] && i<bandwidth) ? delta[row*bandwidth+i] : 0;
+	}
+
+	// anisotropy of outgoing group igout interpolated over the corners of icube
+	template<size_t ndims>
+	float interpolate_delta(const InterpolationCube<ndims>& icube, const size_t igout) const{
+		float result = 0;
+		for(size_t c=0; c<icube.ncorners; c++)
+			result += get_delta(icube.indices[c], igout) * icube.weights[c];
+		return result;
+	}
+};
+
+#endif
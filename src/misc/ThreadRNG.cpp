@@ -31,18 +31,26 @@
 #include "ThreadRNG.h"
 #include "global_options.h"
 
+thread_local RandomStream* ThreadRNG::active = NULL;
+
+ThreadRNG::ThreadRNG(){
+	seed = 0;
+	step = 0;
+}
+
 //-----------------------------------------------------------------
-// initialize the RNG system
+// initialize the RNG system. A negative seed is taken from the clock
+// and broadcast so all ranks share the same key.
 //-----------------------------------------------------------------
 // ASSUMES the number of threads remains constant so it only has to be initialized once
-void ThreadRNG::init(){
+void ThreadRNG::init(const long seed_in){
 	int my_mpiID;
 	MPI_Comm_rank(MPI_COMM_WORLD, &my_mpiID);
 
-	// set up the stuff that creates the random number generators
-	const gsl_rng_type* TypeR = gsl_rng_default;
-	gsl_rng_env_setup();
-
+	long seed_tmp = (seed_in<0 ? (long)time(NULL) : seed_in);
+	MPI_Bcast(&seed_tmp, 1, MPI_LONG, 0, MPI_COMM_WORLD);
+	seed = (uint32_t)seed_tmp;
+	step = 0;
 
 	int nthreads=-1;
 	#pragma omp parallel
@@ -54,27 +62,23 @@ void ThreadRNG::init(){
 		#endif
 	}
 
-	// assign a unique RNG to each thread
-	generators.resize(nthreads);
-	for(int i=0; i<nthreads; i++){
-		gsl_rng_default_seed = (size_t)time(NULL) + my_mpiID*nthreads + i;
-		generators[i] = gsl_rng_alloc (TypeR);
-	}
+	// assign a unique fallback stream to each thread on each rank
+	thread_streams.resize(nthreads);
+	for(int i=0; i<nthreads; i++)
+		start_stream(&thread_streams[i], thread_stream_offset + my_mpiID*nthreads + i, 0);
 }
 
-
-
 //-----------------------------------------------------------------
-// return a uniformily distributed random number (thread safe)
+// point this thread at its own stream
 //-----------------------------------------------------------------
-double ThreadRNG::uniform(){
+void ThreadRNG::bind_thread_stream(){
     #ifdef _OPENMP
 	const int my_ompID = omp_get_thread_num();
     #else
 	const int my_ompID = 0;
     #endif
-
-	return gsl_rng_uniform(generators[my_ompID]);
+	PRINT_ASSERT(my_ompID,<,(int)thread_streams.size());
+	active = &thread_streams[my_ompID];
 }
 
 double ThreadRNG::uniform(const double min, const double max){
@@ -28,22 +28,139 @@
 #ifndef _THREAD_RNG_H
 #define _THREAD_RNG_H
 
-#include <gsl/gsl_rng.h>
 #include <vector>
+#include <stdint.h>
+#include <cstddef>
 
+//-----------------------------------------------------------------
+// Philox-4x32-10 counter-based random stream (Salmon et al. 2011).
+// Each block of four random words is a pure function of the key
+// and the counter, so a stream is fully determined by
+// (seed, step, stream id, draw index) and carries no generator
+// state beyond the counter itself.
+//-----------------------------------------------------------------
+class RandomStream
+{
+
+protected:
+
+	uint32_t key[2];   // (seed, step)
+	uint32_t ctr[4];   // (block index, phase, stream id low, stream id high)
+	uint32_t block[4]; // current block of random words
+	unsigned nused;    // number of words in block already consumed
+
+	static void mulhilo(const uint32_t a, const uint32_t b, uint32_t* hi, uint32_t* lo){
+		const uint64_t product = (uint64_t)a * (uint64_t)b;
+		*hi = product >> 32;
+		*lo = (uint32_t)product;
+	}
+
+	// apply the 10 Philox rounds to the counter and advance it
+	void next_block(){
+		uint32_t x[4] = {ctr[0], ctr[1], ctr[2], ctr[3]};
+		uint32_t k[2] = {key[0], key[1]};
+		for(int round=0; round<10; round++){
+			uint32_t hi0, lo0, hi1, lo1;
+			mulhilo(0xD2511F53, x[0], &hi0, &lo0);
+			mulhilo(0xCD9E8D57, x[2], &hi1, &lo1);
+			x[0] = hi1 ^ x[1] ^ k[0];
+			x[1] = lo1;
+			x[2] = hi0 ^ x[3] ^ k[1];
+			x[3] = lo0;
+			k[0] += 0x9E3779B9;
+			k[1] += 0xBB67AE85;
+		}
+		for(int i=0; i<4; i++) block[i] = x[i];
+		nused = 0;
+		ctr[0]++;
+	}
+
+	// 53-bit double in [0,1) from two random words
+	static double to_double(const uint32_t a, const uint32_t b){
+		return ((a>>5)*67108864.0 + (b>>6)) * (1.0/9007199254740992.0);
+	}
+
+public:
+
+	void init(const uint32_t seed, const uint32_t step, const uint64_t stream_id, const uint32_t phase){
+		key[0] = seed;
+		key[1] = step;
+		ctr[0] = 0;
+		ctr[1] = phase;
+		ctr[2] = (uint32_t)stream_id;
+		ctr[3] = (uint32_t)(stream_id >> 32);
+		nused = 4;
+	}
+
+	double uniform(){
+		if(nused >= 4) next_block();
+		const double result = to_double(block[nused], block[nused+1]);
+		nused += 2;
+		return result;
+	}
+
+	// fill an array with n uniform deviates, two per half-block
+	void uniform_batch(double* out, const size_t n){
+		size_t i=0;
+		for(; i<n && nused<4; i++) out[i] = uniform();
+		for(; i+2<=n; i+=2){
+			next_block();
+			out[i  ] = to_double(block[0], block[1]);
+			out[i+1] = to_double(block[2], block[3]);
+			nused = 4;
+		}
+		for(; i<n; i++) out[i] = uniform();
+	}
+};
+
+//-----------------------------------------------------------------
+// Hands out random numbers from whichever stream the calling
+// thread has bound (normally the stream belonging to the particle
+// it is working on). Threads with no bound stream fall back on
+// a stream of their own.
+//-----------------------------------------------------------------
 class ThreadRNG
 {
 
 protected:
 
-	// OPTIMIZE - to prevent false sharing, make sure all the RNG's are on different cache lines
-	// vector of generators
-	std::vector<gsl_rng*> generators;
+	// streams used by threads that have not bound a particle stream
+	std::vector<RandomStream> thread_streams;
+
+	// stream currently used by this thread
+	static thread_local RandomStream* active;
+	void bind_thread_stream();
 
 public:
 
-	void   init();
-	double uniform();
+	uint32_t seed;
+	uint32_t step; // advances every emission, so each subcycle of each iteration is independent
+
+	// stream ids at or above this are reserved for the per-thread streams
+	static const uint64_t thread_stream_offset = (uint64_t)1 << 63;
+
+	ThreadRNG();
+	void init(const long seed_in);
+
+	// phase lets one particle own several independent streams (e.g. emission and propagation)
+	void start_stream(RandomStream* stream, const uint64_t stream_id, const uint32_t phase) const{
+		stream->init(seed, step, stream_id, phase);
+	}
+	void bind(RandomStream* stream){
+		active = stream;
+	}
+	void unbind(){
+		active = NULL;
+	}
+
+	double uniform(){
+		if(active == NULL) bind_thread_stream();
+		return active->uniform();
+	}
+	void uniform_batch(double* out, const size_t n){
+		if(active == NULL) bind_thread_stream();
+		active->uniform_batch(out, n);
+	}
 	double uniform(const double min, const double max);
 	int    uniform_discrete(const int    min, const int    max);
 };
@@ -46,8 +46,18 @@
 #include <execinfo.h>
 #include <cxxabi.h>
 
-//using real = float; // or float
-//const MPI_Datatype MPI_real = ( sizeof(real)==4 ? MPI_FLOAT : MPI_DOUBLE );
+// Storage type of the large grid tables that are interpolated at random
+// positions every step (opacities and metric). Compile with
+// -DSINGLE_PRECISION_TABLES=1 to halve their memory. Interpolation and
+// tallies are always done in double.
+#ifndef SINGLE_PRECISION_TABLES
+#define SINGLE_PRECISION_TABLES 0
+#endif
+#if SINGLE_PRECISION_TABLES
+using real = float;
+#else
+using real = double;
+#endif
 #define NaN std::numeric_limits<double>::quiet_NaN()
 #define MAXLIM std::numeric_limits<int>::max()
 #define TINY 1e-6
@@ -103,12 +103,12 @@ void Neutrino_GR1D::set_eas_external(const double* easarray, bool* /*extract_MC*
 
 	// first, get opacities everywhere
 	for(int z_ind=0; z_ind<(int)sim->grid->rho.size(); z_ind++){
-		if(ID==0) sim->grid->munue[z_ind] = nulib_eos_munue(sim->grid->rho[z_ind], sim->grid->T[z_ind], sim->grid->Ye[z_ind]);
+		if(ID==0) nulib_eos_chemical_potentials(sim->grid->rho[z_ind], sim->grid->T[z_ind], sim->grid->Ye[z_ind], sim->grid->mue[z_ind], sim->grid->munue[z_ind]);
 		for(int inu=0; inu<ngroups; inu++){
 			size_t dir_ind[NDIMS+1];
 			sim->grid->rho.indices(z_ind,dir_ind);
 			dir_ind[NDIMS] = inu;
-			size_t global_index = sim->grid->abs_opac[ID].direct_index(dir_ind);
+			size_t global_index = sim->grid->eas_opac[ID].direct_index(dir_ind);
 
 			// indexed as eas(zone,species,group,e/a/s). The leftmost one varies fastest.
 			int aind = (z_ind+ghosts1) + ID*n_GR1D_zones + inu*nspecies*n_GR1D_zones + 1*ngroups*nspecies*n_GR1D_zones;
@@ -119,9 +119,9 @@ void Neutrino_GR1D::set_eas_external(const double* easarray, bool* /*extract_MC*
 			PRINT_ASSERT(easarray[sind],>=,0);
 
 			// set opacities
-			sim->grid->abs_opac[ID][global_index] = easarray[aind] / nulib_opacity_gf; // 1/cm
-			sim->grid->scat_opac[ID][global_index] = easarray[sind] / nulib_opacity_gf; // 1/cm
-			sim->grid->inelastic_scat_opac[ID][global_index] = 0; // 1/cm
+			sim->grid->eas_opac[ID][global_index][iabs] = easarray[aind] / nulib_opacity_gf; // 1/cm
+			sim->grid->eas_opac[ID][global_index][iscat] = easarray[sind] / nulib_opacity_gf; // 1/cm
+			sim->grid->eas_opac[ID][global_index][iinelastic] = 0; // 1/cm
 		}
 	}
 }
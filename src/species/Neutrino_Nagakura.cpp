@@ -30,6 +30,7 @@
 #include "Transport.h"
 #include "Grid.h"
 #include "nulib_interface.h"
+#include "H5Cpp.h"
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -37,6 +38,11 @@
 using namespace std;
 namespace pc = physical_constants;
 
+// opacity cube written by nagakura_opacity_convert, shared by all species.
+// indexed [r][theta][group][species][emis,abs,scat], theta in Hiroki's order
+vector<double> nagakura_eas;
+hsize_t nagakura_eas_dims[5] = {0,0,0,0,0};
+
 
 // constructor
 Neutrino_Nagakura::Neutrino_Nagakura(){
@@ -49,6 +55,26 @@ void Neutrino_Nagakura::myInit(Lua* lua)
 {
     // set up the frequency table
     opacity_dir   = lua->scalar<string>("opacity_dir");
+    opacity_file  = lua->scalar<string>("Nagakura_opacity_file");
+    if(opacity_file.size()>0 && nagakura_eas.size()==0) read_opacity_file();
+}
+
+//----------------------------------------------------------------
+// read the whole opacity cube with one read
+//----------------------------------------------------------------
+void Neutrino_Nagakura::read_opacity_file() const
+{
+	H5::H5File file(opacity_file, H5F_ACC_RDONLY);
+	H5::DataSet dataset = file.openDataSet("eas");
+	H5::DataSpace dataspace = dataset.getSpace();
+	PRINT_ASSERT(dataspace.getSimpleExtentNdims(),==,5);
+	dataspace.getSimpleExtentDims(nagakura_eas_dims);
+	PRINT_ASSERT(nagakura_eas_dims[3],==,3);
+	PRINT_ASSERT(nagakura_eas_dims[4],==,3);
+	nagakura_eas.resize(nagakura_eas_dims[0]*nagakura_eas_dims[1]*nagakura_eas_dims[2]*nagakura_eas_dims[3]*nagakura_eas_dims[4]);
+	dataset.read(&nagakura_eas[0], H5::PredType::IEEE_F64LE);
+	dataset.close();
+	file.close();
 }
 
 
@@ -61,25 +87,51 @@ void Neutrino_Nagakura::set_eas(const size_t zone_index, Grid* grid) const
 	grid->rho.indices(zone_index,dir_ind);
 
 
-	//=======================//
-    // Open the opacity file //
-	//=======================//
-	stringstream filename;
+	//======================//
+	// find the zone's file //
+	//======================//
+	size_t ir=0, itheta=0;
 	if(grid->grid_type == "Grid1DSphere"){
-		filename.str("");
-	    filename << opacity_dir << "/opac_r" << zone_index << "_theta0.dat";
+		ir = zone_index;
 	}
 	else if(grid->grid_type == "Grid2DSphere"){
 		Tuple<size_t,NDIMS> dir_ind = grid->zone_directional_indices(zone_index);
 		Tuple<hsize_t,NDIMS> dims = grid->dims();
-		filename.str("");
-		filename << opacity_dir << "/opac_r" << dir_ind[0] << "_theta" << (dims[1]-dir_ind[1]-1) << ".dat"; // Hiroki's theta is backwards
+		ir = dir_ind[0];
+		itheta = dims[1]-dir_ind[1]-1; // Hiroki's theta is backwards
 	}
 	else{
 		cout << "ERROR: Incompatible grid and neutrino types. Hiroki only does spherical coordinates." << endl;
 		cout << grid->grid_type << endl;
 		assert(false);
 	}
+
+	//===================================//
+	// copy from the preloaded opacities //
+	//===================================//
+	if(nagakura_eas.size()>0){
+		PRINT_ASSERT(ir,<,nagakura_eas_dims[0]);
+		PRINT_ASSERT(itheta,<,nagakura_eas_dims[1]);
+		PRINT_ASSERT(nagakura_eas_dims[2],==,grid->nu_grid_axis.size());
+		PRINT_ASSERT(ID,<,nagakura_eas_dims[3]);
+		for(size_t inu=0; inu<grid->nu_grid_axis.size(); inu++){
+			dir_ind[NDIMS] = inu;
+			size_t global_index = grid->eas_opac[ID].direct_index(dir_ind);
+			const double* eas = &nagakura_eas[(((ir*nagakura_eas_dims[1] + itheta)*nagakura_eas_dims[2] + inu)*3 + ID)*3];
+			grid->eas_opac[ID][global_index][iabs] = eas[1];
+			grid->eas_opac[ID][global_index][iscat] = eas[2];
+			grid->eas_opac[ID][global_index][iinelastic] = 0;
+			if(grid->scattering_kernel[ID].size()>0)
+				grid->scattering_kernel[ID].wipe_row(global_index);
+		}
+		return;
+	}
+
+	//=======================//
+    // Open the opacity file //
+	//=======================//
+	stringstream filename;
+	filename << opacity_dir << "/opac_r" << ir << "_theta" << itheta << ".dat";
     ifstream opac_file;
     opac_file.open(filename.str().c_str());
 
@@ -92,7 +144,7 @@ void Neutrino_Nagakura::set_eas(const size_t zone_index, Grid* grid) const
 
     for(size_t inu=0; inu<grid->nu_grid_axis.size(); inu++){
     	dir_ind[NDIMS] = inu;
-    	size_t global_index = grid->abs_opac[ID].direct_index(dir_ind);
+    	size_t global_index = grid->eas_opac[ID].direct_index(dir_ind);
 
     	int itmp;
     	double a=0, s=0;
@@ -153,15 +205,13 @@ void Neutrino_Nagakura::set_eas(const size_t zone_index, Grid* grid) const
     		cout << "ERROR: Neutrino ID not recognized!" << endl;
     		assert(false);
     	}
-    	grid->abs_opac[ID][global_index] = a;
-    	grid->scat_opac[ID][global_index] = s;
+    	grid->eas_opac[ID][global_index][iabs] = a;
+    	grid->eas_opac[ID][global_index][iscat] = s;
+    	grid->eas_opac[ID][global_index][iinelastic] = 0;
 
     	// fill in the scattering kernel if used
-		if(grid->inelastic_scat_opac[ID].size()>0){
-	    	grid->inelastic_scat_opac[ID][global_index] = 0;
-			grid->scattering_delta[ID][inu].wipe();
-			grid->partial_scat_opac[ID][inu].wipe();
-		}
+		if(grid->scattering_kernel[ID].size()>0)
+			grid->scattering_kernel[ID].wipe_row(global_index);
     }
     opac_file.close();
 }
@@ -36,6 +36,8 @@ class Neutrino_Nagakura: public Species
 protected:
 
 	std::string opacity_dir;
+	std::string opacity_file;
+	void read_opacity_file() const;
 
 public:
 
@@ -37,17 +37,44 @@ namespace pc = physical_constants;
 
 // constructor
 Neutrino_NuLib::Neutrino_NuLib(){
+	native_interpolation = -MAXLIM;
 }
 
 //----------------------------------------------------------------
 // called from species_general::init (neutrino-specific stuff)
 //----------------------------------------------------------------
-void Neutrino_NuLib::myInit(Lua* /*lua*/)
+void Neutrino_NuLib::myInit(Lua* lua)
 {
-// do nothing
+	native_interpolation = lua->scalar<int>("nulib_native_interpolation");
+	if(nulib_using_preprocessed_table() and !native_interpolation){
+		cout << "ERROR: preprocessed NuLib tables require nulib_native_interpolation=1" << endl;
+		assert(false);
+	}
+	if(native_interpolation) nulib_init_native();
+	if(lua->scalar<int>("nulib_kernel_cache")) nulib_init_kernel_cache();
 }
 
 
+//-----------------------------------------------------------------
+// set the chemical potentials in zones. The first species does it
+// for everyone, since they all use the same EOS.
+//-----------------------------------------------------------------
+void Neutrino_NuLib::set_eos(const size_t z_ind, Grid* grid) const
+{
+	if(ID!=0) return;
+	const double rho = grid->rho[z_ind];
+	const double T = grid->T[z_ind];
+	const double Ye = grid->Ye[z_ind];
+
+	// the opacity tables clamp Ye, so the kernels need mue at the clamped value
+	const double Ye_eas = max(nulib_get_Yemin(), min(nulib_get_Yemax(), Ye));
+	if(Ye_eas == Ye) nulib_eos_chemical_potentials(rho, T, Ye, grid->mue[z_ind], grid->munue[z_ind]);
+	else{
+		grid->munue[z_ind] = nulib_eos_munue(rho, T, Ye);
+		grid->mue[z_ind] = nulib_eos_mue(rho, T, Ye_eas);
+	}
+}
+
 //-----------------------------------------------------------------
 // set emissivity, abs. opacity, and scat. opacity in zones
 //-----------------------------------------------------------------
@@ -56,31 +83,60 @@ void Neutrino_NuLib::set_eas(const size_t z_ind, Grid* grid) const
 	size_t ngroups = grid->nu_grid_axis.size();
 	size_t dir_ind[NDIMS+1];
 	grid->rho.indices(z_ind,dir_ind);
+	if(native_interpolation){
+		set_eas_native(z_ind, grid);
+		return;
+	}
 
 	vector<double> tmp_absopac(ngroups), tmp_scatopac(ngroups);
 	vector< vector<double> > tmp_delta(ngroups, vector<double>(ngroups)); //[igin][igout]
 	vector< vector<double> > tmp_partial_opac(ngroups, vector<double>(ngroups));  //[igin][igout]
-	nulib_get_eas_arrays(grid->rho[z_ind], grid->T[z_ind], grid->Ye[z_ind], ID,
+	nulib_get_eas_arrays(grid->rho[z_ind], grid->T[z_ind], grid->Ye[z_ind], ID, grid->mue[z_ind],
 			tmp_absopac, tmp_scatopac, tmp_partial_opac, tmp_delta);
 
-	if(ID==0) grid->munue[z_ind] = nulib_eos_munue(grid->rho[z_ind], grid->T[z_ind], grid->Ye[z_ind]);
 	for(size_t igin=0; igin<ngroups; igin++){
 		dir_ind[NDIMS] = igin;
-		size_t global_index = grid->abs_opac[ID].direct_index(dir_ind);
-		grid->abs_opac[ID][global_index] = tmp_absopac[igin];
-		grid->scat_opac[ID][global_index] = tmp_scatopac[igin];
-
-		if(grid->inelastic_scat_opac[ID].size()>0){
-			grid->inelastic_scat_opac[ID][global_index] = 0;
-			for(size_t igout=0; igout<ngroups; igout++){
-				grid->partial_scat_opac[ID][igout][global_index] = tmp_partial_opac[igin][igout];
-				grid->inelastic_scat_opac[ID][global_index] += grid->partial_scat_opac[ID][igout][global_index];
-				grid->scattering_delta[ID][igout][global_index] = tmp_delta[igin][igout];
-			}
-		}
+		size_t global_index = grid->eas_opac[ID].direct_index(dir_ind);
+		grid->eas_opac[ID][global_index][iabs] = tmp_absopac[igin];
+		grid->eas_opac[ID][global_index][iscat] = tmp_scatopac[igin];
+		grid->eas_opac[ID][global_index][iinelastic] = 0;
+
+		if(grid->scattering_kernel[ID].size()>0)
+			grid->eas_opac[ID][global_index][iinelastic] =
+					grid->scattering_kernel[ID].set_row(global_index, &tmp_partial_opac[igin][0], &tmp_delta[igin][0]);
 	}
 }
 
-void Neutrino_NuLib::get_annihil_kernels(const double rho, const double T, const double Ye, const Axis& /*nuAxis*/, vector< vector< vector<double> > >& phi) const{
-	nulib_get_epannihil_kernels(rho, T, Ye, ID, phi);
+// same as set_eas, but the opacities are interpolated in C++. They are computed in
+// double and then stored in the grid, whose tables may be single precision.
+void Neutrino_NuLib::set_eas_native(const size_t z_ind, Grid* grid) const
+{
+	size_t ngroups = grid->nu_grid_axis.size();
+	size_t dir_ind[NDIMS+1];
+	grid->rho.indices(z_ind,dir_ind);
+	dir_ind[NDIMS] = 0;
+	PRINT_ASSERT(grid->eas_opac[ID].stride[NDIMS],==,1);
+	const size_t global_index0 = grid->eas_opac[ID].direct_index(dir_ind);
+	vector<Tuple<double,3> > eas(ngroups);
+	const size_t stride = sizeof(Tuple<double,3>) / sizeof(double);
+	nulib_get_eas_arrays_native(1, &grid->rho[z_ind], &grid->T[z_ind], &grid->Ye[z_ind], ID,
+			&eas[0][iabs], &eas[0][iscat], stride);
+	for(size_t igin=0; igin<ngroups; igin++) eas[igin][iinelastic] = 0;
+
+	// inelastic kernels still come from NuLib
+	if(nulib_has_inelastic_kernels() && !nulib_below_eas_table(grid->rho[z_ind], grid->T[z_ind])){
+		vector< vector<double> > tmp_delta(ngroups, vector<double>(ngroups)); //[igin][igout]
+		vector< vector<double> > tmp_partial_opac(ngroups, vector<double>(ngroups));  //[igin][igout]
+		nulib_get_iscatter_kernels(grid->T[z_ind], grid->mue[z_ind], ID, tmp_partial_opac, tmp_delta);
+		for(size_t igin=0; igin<ngroups; igin++)
+			eas[igin][iinelastic] = grid->scattering_kernel[ID].set_row(global_index0+igin, &tmp_partial_opac[igin][0], &tmp_delta[igin][0]);
+	}
+	else for(size_t igin=0; igin<ngroups; igin++)
+		grid->scattering_kernel[ID].wipe_row(global_index0+igin);
+
+	for(size_t igin=0; igin<ngroups; igin++) grid->eas_opac[ID][global_index0+igin] = eas[igin];
+}
+
+void Neutrino_NuLib::get_annihil_kernels(const double /*rho*/, const double T, const double /*Ye*/, const double mue, const Axis& /*nuAxis*/, vector< vector< vector<double> > >& phi) const{
+	nulib_get_epannihil_kernels(T, mue, ID, phi);
 }
@@ -35,13 +35,18 @@ class Neutrino_NuLib: public Species
 
 protected:
 
+	// 1 --> interpolate the eas tables in C++, 0 --> use NuLib's fortran routines
+	int native_interpolation;
+	void set_eas_native(const size_t z_ind, Grid* grid) const;
+
 public:
 
 	Neutrino_NuLib();
 
 	void myInit(Lua* lua);
 	void set_eas(const size_t z_ind, Grid* grid) const;
-	void get_annihil_kernels(const double rho, const double T, const double Ye, const Axis& nuAxis, vector< vector< vector<double> > >& phi) const;
+	void set_eos(const size_t z_ind, Grid* grid) const;
+	void get_annihil_kernels(const double rho, const double T, const double Ye, const double mue, const Axis& nuAxis, vector< vector< vector<double> > >& phi) const;
 };
 
 #endif
@@ -38,6 +38,7 @@ Neutrino_grey::Neutrino_grey(){
 	Neutrino_grey_opac = NaN;
 	Neutrino_grey_abs_frac = NaN;
 	Neutrino_grey_chempot = NaN;
+	Neutrino_grey_tabulated = -1;
 }
 
 //----------------------------------------------------------------
@@ -48,39 +49,55 @@ void Neutrino_grey::myInit(Lua* lua)
 	Neutrino_grey_abs_frac = lua->scalar<double>("Neutrino_grey_abs_frac");
 	Neutrino_grey_opac     = lua->scalar<double>("Neutrino_grey_opac");
 	Neutrino_grey_chempot = lua->scalar<double>("Neutrino_grey_chempot") * pc::MeV_to_ergs;
+	Neutrino_grey_tabulated = lua->scalar<int>("Neutrino_grey_tabulated");
+	PRINT_ASSERT(Neutrino_grey_abs_frac,>=,0);
+	PRINT_ASSERT(Neutrino_grey_abs_frac,<=,1.0);
+	analytic_opacities = !Neutrino_grey_tabulated;
+}
+
+//-----------------------------------------------------------------
+// the equilibrium chemical potential is a constant
+//-----------------------------------------------------------------
+void Neutrino_grey::set_eos(const size_t z_ind, Grid* grid) const
+{
+	grid->munue[z_ind] = Neutrino_grey_chempot;
+}
+
+//-----------------------------------------------------------------
+// abs. and scat. opacity (1/cm) at any density and frequency
+//-----------------------------------------------------------------
+void Neutrino_grey::get_opacities(const double rho, const double /*T*/, const double /*Ye*/, const double /*nu*/, double* absopac, double* scatopac) const
+{
+	*absopac = Neutrino_grey_opac*rho*Neutrino_grey_abs_frac;
+	*scatopac = Neutrino_grey_opac*rho*(1.0-Neutrino_grey_abs_frac);
+	PRINT_ASSERT(*absopac,>=,0);
+	PRINT_ASSERT(*scatopac,>=,0);
 }
 
 
 //-----------------------------------------------------------------
 // set emissivity, abs. opacity, and scat. opacity in zones
+// (only when Neutrino_grey_tabulated)
 //-----------------------------------------------------------------
 void Neutrino_grey::set_eas(const size_t z_ind, Grid* grid) const
 {
-	size_t ngroups = grid->nu_grid_axis.size();
 	size_t dir_ind[NDIMS+1];
 	grid->rho.indices(z_ind,dir_ind);
 
-	PRINT_ASSERT(Neutrino_grey_abs_frac,>=,0);
-	PRINT_ASSERT(Neutrino_grey_abs_frac,<=,1.0);
-	grid->munue[z_ind] = Neutrino_grey_chempot;
 	for(size_t j=0;j<grid->nu_grid_axis.size();j++)
 	{
 		dir_ind[NDIMS] = j;
-		size_t global_index = grid->abs_opac[ID].direct_index(dir_ind);
+		size_t global_index = grid->eas_opac[ID].direct_index(dir_ind);
 
-		double a = Neutrino_grey_opac*grid->rho[z_ind]*Neutrino_grey_abs_frac;
-		double s = Neutrino_grey_opac*grid->rho[z_ind]*(1.0-Neutrino_grey_abs_frac);
-		PRINT_ASSERT(a,>=,0);
-		PRINT_ASSERT(s,>=,0);
+		double a, s;
+		get_opacities(grid->rho[z_ind], grid->T[z_ind], grid->Ye[z_ind], grid->nu_grid_axis.mid[j], &a, &s);
 
-		grid->abs_opac[ID][global_index] = a;        // (1/cm)
-		grid->scat_opac[ID][global_index] = s;        // (1/cm)
+		grid->eas_opac[ID][global_index][iabs] = a;        // (1/cm)
+		grid->eas_opac[ID][global_index][iscat] = s;        // (1/cm)
+		grid->eas_opac[ID][global_index][iinelastic] = 0;  // (1/cm)
 
-		if(grid->inelastic_scat_opac[ID].size()>0){
-			grid->inelastic_scat_opac[ID][global_index] = 0;
-			grid->scattering_delta[ID][j].wipe();
-			grid->partial_scat_opac[ID][j].wipe();
-		}
+		if(grid->scattering_kernel[ID].size()>0)
+			grid->scattering_kernel[ID].wipe_row(global_index);
 	}
 }
 
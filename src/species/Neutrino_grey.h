@@ -39,13 +39,16 @@ protected:
 	double Neutrino_grey_opac; //(cm^2/g)
 	double Neutrino_grey_abs_frac;       //unitless
 	double Neutrino_grey_chempot; // erg
+	int Neutrino_grey_tabulated;   // fill eas_opac instead of computing opacities on the fly
 
 public:
 
 	Neutrino_grey();
 
 	void myInit(Lua* lua);
+	void set_eos(const size_t z_ind, Grid* grid) const;
 	void set_eas(const size_t z_ind, Grid* grid) const;
+	void get_opacities(const double rho, const double T, const double Ye, const double nu, double* absopac, double* scatopac) const;
 };
 
 #endif
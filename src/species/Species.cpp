@@ -48,6 +48,7 @@ Species::Species(){
 	T_core = NaN;
 	mu_core = NaN;
 	core_lum_multiplier = NaN;
+	analytic_opacities = false;
 }
 
 void Species::init(Lua* lua)
@@ -85,8 +86,17 @@ void Species::init(Lua* lua)
 	myInit(lua);
 }
 
+// by default the species doesn't need anything from the EOS
+void Species::set_eos(const size_t /*z_ind*/, Grid* /*grid*/) const{}
+
+// only species with analytic_opacities can be asked
+void Species::get_opacities(const double /*rho*/, const double /*T*/, const double /*Ye*/, const double /*nu*/, double* /*absopac*/, double* /*scatopac*/) const{
+	cout << "ERROR: " << name << " does not have analytic opacities." << endl;
+	assert(0);
+}
+
 // cm^3/s
-void Species::get_annihil_kernels(const double /*rho*/, const double /*T*/, const double /*Ye*/, const Axis& nuAxis, vector< vector< vector<double> > >& phi) const{
+void Species::get_annihil_kernels(const double /*rho*/, const double /*T*/, const double /*Ye*/, const double /*mue*/, const Axis& nuAxis, vector< vector< vector<double> > >& phi) const{
 	// constants
 	using namespace pc;
 	double mec2 = m_e*c*c; // erg
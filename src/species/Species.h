@@ -68,7 +68,16 @@ public:
 
 	// set the emissivity, absorption opacity, and scattering opacity
 	virtual void set_eas(const size_t z_ind, Grid* grid) const = 0;
-	virtual void get_annihil_kernels(const double rho, const double T, const double Ye, const Axis& nuAxis, vector< vector< vector<double> > >& phi) const;
+
+	// Species whose opacities are simple functions of the fluid state set
+	// analytic_opacities in myInit. The grid then stores no eas_opac table
+	// for them, set_eas is never called, and each particle gets its
+	// opacities from get_opacities at its own position and frequency.
+	bool analytic_opacities;
+	virtual void get_opacities(const double rho, const double T, const double Ye, const double nu, double* absopac, double* scatopac) const;
+	// set the zone's thermodynamic quantities (grid->munue, grid->mue) before any set_eas
+	virtual void set_eos(const size_t z_ind, Grid* grid) const;
+	virtual void get_annihil_kernels(const double rho, const double T, const double Ye, const double mue, const Axis& nuAxis, vector< vector< vector<double> > >& phi) const;
 };
 
 
@@ -29,6 +29,12 @@
 #include <cmath>
 #include <string>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "nulib_interface.h"
 #include "global_options.h"
 #include "H5Cpp.h"
@@ -98,6 +104,9 @@ double* nulibtable_logtemp;
 double* nulibtable_ye;
 double* nulibtable_logItemp;
 double* nulibtable_logIeta;
+double* nulibtable_absopacity;  // log10(1/cm) [nulib species*group][ye][temp][rho] (fortran order reversed)
+double* nulibtable_scatopacity; // log10(1/cm)
+double* nulibtable_delta;       // only if read_delta
 double  nulibtable_logtemp_min;
 double  nulibtable_logtemp_max;
 double  nulibtable_logrho_min;
@@ -113,6 +122,17 @@ int     read_Ielectron;
 int     read_epannihil;
 int     read_delta;
 
+// copy of the eas tables rearranged for nulib_get_eas_arrays_native
+// [ye][temp][rho][species][log10(abs), log10(scat), (delta)][group]
+// Points either into nulibtable_native_eas_storage or into a preprocessed table
+vector<double> nulibtable_native_eas_storage;
+const double* nulibtable_native_eas = NULL;
+int nulibtable_native_nvars = 0;
+
+// set if the table was memory mapped from a preprocessed file
+// (see nulib_write_preprocessed_table). There is no fortran copy then.
+int nulib_table_preprocessed = 0;
+
 // The format of the fortran variables the fortran compiler provides
 // assumes C and Fortran compilers are the same
 // To be copied into the universal globals if intel compiler
@@ -134,6 +154,9 @@ extern double* nulibtable_mp_nulibtable_logtemp_;
 extern double* nulibtable_mp_nulibtable_ye_;
 extern double* nulibtable_mp_nulibtable_logitemp_;
 extern double* nulibtable_mp_nulibtable_logieta_;
+extern double* nulibtable_mp_nulibtable_absopacity_;
+extern double* nulibtable_mp_nulibtable_scatopacity_;
+extern double* nulibtable_mp_nulibtable_delta_;
 extern double  nulibtable_mp_nulibtable_logtemp_min_;
 extern double  nulibtable_mp_nulibtable_logtemp_max_;
 extern double  nulibtable_mp_nulibtable_logrho_min_;
@@ -163,6 +186,9 @@ extern double* __nulibtable_MOD_nulibtable_logtemp;
 extern double* __nulibtable_MOD_nulibtable_ye;
 extern double* __nulibtable_MOD_nulibtable_logitemp;
 extern double* __nulibtable_MOD_nulibtable_logieta;
+extern double* __nulibtable_MOD_nulibtable_absopacity;
+extern double* __nulibtable_MOD_nulibtable_scatopacity;
+extern double* __nulibtable_MOD_nulibtable_delta;
 extern double  __nulibtable_MOD_nulibtable_logtemp_min;
 extern double  __nulibtable_MOD_nulibtable_logtemp_max;
 extern double  __nulibtable_MOD_nulibtable_logrho_min;
@@ -203,6 +229,9 @@ void nulibtable_set_globals(){
 	nulibtable_ye                   = nulibtable_mp_nulibtable_ye_;
 	nulibtable_logItemp             = nulibtable_mp_nulibtable_logitemp_;
 	nulibtable_logIeta              = nulibtable_mp_nulibtable_logieta_;
+	nulibtable_absopacity           = nulibtable_mp_nulibtable_absopacity_;
+	nulibtable_scatopacity          = nulibtable_mp_nulibtable_scatopacity_;
+	nulibtable_delta                = nulibtable_mp_nulibtable_delta_;
 	nulibtable_logtemp_min          = nulibtable_mp_nulibtable_logtemp_min_;
 	nulibtable_logtemp_max          = nulibtable_mp_nulibtable_logtemp_max_;
 	nulibtable_logrho_min           = nulibtable_mp_nulibtable_logrho_min_;
@@ -232,6 +261,9 @@ void nulibtable_set_globals(){
 	nulibtable_ye                  = __nulibtable_MOD_nulibtable_ye;
 	nulibtable_logItemp            = __nulibtable_MOD_nulibtable_logitemp;
 	nulibtable_logIeta             = __nulibtable_MOD_nulibtable_logieta;
+	nulibtable_absopacity          = __nulibtable_MOD_nulibtable_absopacity;
+	nulibtable_scatopacity         = __nulibtable_MOD_nulibtable_scatopacity;
+	nulibtable_delta               = __nulibtable_MOD_nulibtable_delta;
 	nulibtable_logtemp_min         = __nulibtable_MOD_nulibtable_logtemp_min;
 	nulibtable_logtemp_max         = __nulibtable_MOD_nulibtable_logtemp_max;
 	nulibtable_logrho_min          = __nulibtable_MOD_nulibtable_logrho_min;
@@ -272,19 +304,7 @@ int nulib_get_nspecies(){
 /**************/
 /* nulib_init */
 /**************/
-void nulib_init(string filename){
-	read_Ielectron = 0;
-	read_epannihil = 0;
-	read_delta = 0;
-	if(hdf5_dataset_exists(filename.c_str(),"/scattering_delta")) read_delta = 1;
-	if(hdf5_dataset_exists(filename.c_str(),"/inelastic_phi0"))   read_Ielectron = 1;
-	if(hdf5_dataset_exists(filename.c_str(),"/epannihil_phi0") or hdf5_dataset_exists(filename.c_str(),"/bremsstrahlung_phi0"))
-    	read_epannihil = 1;
-
-	nulibtable_reader_((char*)filename.c_str(), &read_Ielectron, &read_epannihil, &read_delta, filename.length());
-	nulibtable_set_globals();
-
-	// output some facts about the table
+void nulib_print_table_facts(){
 	int my_rank=-1;
 	MPI_Comm_rank( MPI_COMM_WORLD, &my_rank );
 	if(my_rank==0){
@@ -301,14 +321,156 @@ void nulib_init(string filename){
 	}
 }
 
+void nulib_init(string filename){
+	if(nulib_is_preprocessed_table(filename)){
+		nulib_init_preprocessed(filename);
+		nulib_print_table_facts();
+		return;
+	}
+
+	read_Ielectron = 0;
+	read_epannihil = 0;
+	read_delta = 0;
+	if(hdf5_dataset_exists(filename.c_str(),"/scattering_delta")) read_delta = 1;
+	if(hdf5_dataset_exists(filename.c_str(),"/inelastic_phi0"))   read_Ielectron = 1;
+	if(hdf5_dataset_exists(filename.c_str(),"/epannihil_phi0") or hdf5_dataset_exists(filename.c_str(),"/bremsstrahlung_phi0"))
+    	read_epannihil = 1;
+
+	nulibtable_reader_((char*)filename.c_str(), &read_Ielectron, &read_epannihil, &read_delta, filename.length());
+	nulibtable_set_globals();
+
+	// output some facts about the table
+	nulib_print_table_facts();
+}
+
+
+/****************/
+/* Kernel cache */
+/****************/
+// The inelastic and pair kernels only depend on (T,eta), and NuLib tabulates
+// them on a (log T, log eta) grid. The kernels are memoized at those grid
+// nodes the first time a zone needs them and interpolated in between,
+// bilinear in log(phi0) and in phi1/phi0 the same way NuLib does. The first
+// half of the kernels returned by NuLib are phi0, the second half the matching phi1.
+typedef void (*nulib_kernel_function)(double*, double*, int*, double*, int*, int*, int*);
+class NuLibKernelCache{
+public:
+	nulib_kernel_function fortran_kernels;
+	int nphis;
+	vector<vector<double> > node_data;  // [species*nnodes + iT*nIeta+ieta][phi][group][group] stores log10(phi0) and phi1/phi0
+	vector<ATOMIC<char> > node_ready;
+	const double* mapped_nodes;         // all nodes back to back, from a preprocessed table
+
+	NuLibKernelCache(nulib_kernel_function f, const int nphis_in){
+		fortran_kernels = f;
+		nphis = nphis_in;
+		mapped_nodes = NULL;
+	}
+
+	size_t nnodes() const{
+		return (size_t)nulibtable_number_species * nulibtable_nItemp * nulibtable_nIeta;
+	}
+	size_t node_size() const{
+		return (size_t)nphis * nulibtable_number_groups * nulibtable_number_groups;
+	}
+
+	// write every node in order, filling the missing ones
+	void write(ofstream& outfile){
+		for(int lns=1; lns<=nulibtable_number_species; lns++)
+			for(int iT=0; iT<nulibtable_nItemp; iT++)
+				for(int ieta=0; ieta<nulibtable_nIeta; ieta++)
+					outfile.write((const char*)get_node(lns,iT,ieta), node_size()*sizeof(double));
+	}
+
+	void init(){
+		const size_t nnodes = (size_t)nulibtable_nItemp * nulibtable_nIeta;
+		node_data.resize(nulibtable_number_species * nnodes);
+		node_ready.assign(node_data.size(), 0);
+	}
+
+	// kernels at one table node, calling NuLib if not done yet
+	const double* get_node(int lns, const int iT, const int ieta){
+		const size_t i = (lns-1)*(size_t)nulibtable_nItemp*nulibtable_nIeta + iT*nulibtable_nIeta + ieta;
+		if(mapped_nodes!=NULL) return mapped_nodes + i*node_size();
+		PRINT_ASSERT(i,<,node_data.size());
+		if(not node_ready[i].load(std::memory_order_acquire)){
+			#pragma omp critical(nulib_kernel_cache)
+			if(not node_ready[i].load(std::memory_order_acquire)){
+				int ngroups = nulibtable_number_groups;
+				const size_t n2 = ngroups*ngroups;
+				double temp_MeV = pow(10.0, nulibtable_logItemp[iT]);
+				double eta = pow(10.0, nulibtable_logIeta[ieta]);
+				vector<double> phi(nphis*n2);
+				fortran_kernels(&temp_MeV, &eta, &lns, &phi[0], &ngroups, &ngroups, &nphis);
+				for(size_t a=0; a<(size_t)nphis/2; a++)
+					for(size_t k=0; k<n2; k++){
+						const double phi0 = phi[a*n2+k];
+						double& phi1 = phi[(a+nphis/2)*n2+k];
+						phi1 = (phi0==0 ? 0 : phi1/phi0);
+						phi[a*n2+k] = log10(phi0);
+					}
+				node_data[i].swap(phi);
+				node_ready[i].store(1, std::memory_order_release);
+			}
+		}
+		return &node_data[i][0];
+	}
+
+	// fill phi[nphis][ngroups][ngroups] like the fortran routine would
+	void interpolate(const double temp_MeV, const double eta, const int lns, double* phi){
+		const double x[2] = {log10(temp_MeV), log10(eta)};
+		const double* xt[2] = {nulibtable_logItemp, nulibtable_logIeta};
+		const int nx[2] = {nulibtable_nItemp, nulibtable_nIeta};
+		int ix[2];
+		double f[2];
+		for(size_t d=0; d<2; d++){
+			ix[d] = upper_bound(xt[d], xt[d]+nx[d], x[d]) - xt[d] - 1;
+			ix[d] = max(0, min(nx[d]-2, ix[d]));
+			f[d] = (x[d] - xt[d][ix[d]]) / (xt[d][ix[d]+1] - xt[d][ix[d]]);
+			f[d] = max(0., min(1., f[d]));
+		}
+		const double* corner[4] = {
+				get_node(lns, ix[0]  , ix[1]  ),
+				get_node(lns, ix[0]  , ix[1]+1),
+				get_node(lns, ix[0]+1, ix[1]  ),
+				get_node(lns, ix[0]+1, ix[1]+1)};
+		const double w[4] = {(1.-f[0])*(1.-f[1]), (1.-f[0])*f[1], f[0]*(1.-f[1]), f[0]*f[1]};
+
+		const size_t n2 = nulibtable_number_groups * nulibtable_number_groups;
+		for(size_t a=0; a<(size_t)nphis/2; a++){
+			const size_t i0 = a*n2, i1 = (a+nphis/2)*n2;
+			for(size_t k=0; k<n2; k++){
+				double logphi0=0, ratio=0;
+				for(size_t c=0; c<4; c++){
+					if(w[c]==0) continue; // avoid 0*-inf where phi0 vanishes
+					logphi0 += w[c] * corner[c][i0+k];
+					ratio   += w[c] * corner[c][i1+k];
+				}
+				phi[i0+k] = pow(10.0, logphi0);
+				phi[i1+k] = ratio * phi[i0+k];
+			}
+		}
+	}
+};
+int nulib_use_kernel_cache = 0;
+NuLibKernelCache inelastic_kernel_cache(nulibtable_inelastic_single_species_range_energy_, 2);
+NuLibKernelCache epannihil_kernel_cache(nulibtable_epannihil_single_species_range_energy_, 4);
+
+void nulib_init_kernel_cache(){
+	if(nulib_use_kernel_cache) return;
+	PRINT_ASSERT(nulibtable_nItemp,>=,2);
+	PRINT_ASSERT(nulibtable_nIeta,>=,2);
+	inelastic_kernel_cache.init();
+	epannihil_kernel_cache.init();
+	nulib_use_kernel_cache = 1;
+}
 
 /********************************/
 /* Inelastic scattering kernels */
 /********************************/
 void nulib_get_iscatter_kernels(
-		const double rho, // g/ccm
 		const double temp, // K
-		const double ye,
+		const double mue,  // erg, electron chemical potential
 		const int nulibID,
 		vector< vector<double> >& partial_opac,       // 2pi h^-3 c^-4 phi0 delta(E^3/3)/deltaE [group in][group out] units 1/cm
 		vector< vector<double> >& scattering_delta){  // 3.*phi1/phi0   [group_in][group_out]
@@ -321,9 +483,8 @@ void nulib_get_iscatter_kernels(
 	//PRINT_ASSERT(nulibtable_nItemp,>,0);
 	PRINT_ASSERT(nulibID,>=,0);
 
-	// get the chemical potential
-	double mue = nulib_eos_mue(rho,temp,ye)*pc::ergs_to_MeV; // MeV
-	double eta = mue/temp_MeV;
+	// degeneracy parameter
+	double eta = mue*pc::ergs_to_MeV / temp_MeV;
 	eta = max(eta,pow(10.0,nulibtable_logIeta_min));
 	eta = min(eta,pow(10.0,nulibtable_logIeta_max));
 	PRINT_ASSERT(eta,<=,pow(10.0,nulibtable_logIeta_max));
@@ -336,7 +497,8 @@ void nulib_get_iscatter_kernels(
 	if(read_Ielectron>0){
 		PRINT_ASSERT(temp_MeV,<=,pow(10.0,nulibtable_logItemp_max));
 		PRINT_ASSERT(temp_MeV,>=,pow(10.0,nulibtable_logItemp_min));
-		nulibtable_inelastic_single_species_range_energy_(&temp_MeV, &eta, &lns, (double*)phi,
+		if(nulib_use_kernel_cache) inelastic_kernel_cache.interpolate(temp_MeV, eta, lns, (double*)phi);
+		else nulibtable_inelastic_single_species_range_energy_(&temp_MeV, &eta, &lns, (double*)phi,
 				&ngroups, &ngroups, &n_legendre_coefficients);
 	}
 
@@ -369,9 +531,8 @@ void nulib_get_iscatter_kernels(
 /* Annihilation kernels */
 /************************/
 void nulib_get_epannihil_kernels(
-		const double rho, // g/ccm
 		const double temp, // K
-		const double ye,
+		const double mue,  // erg, electron chemical potential
 		const int nulibID,
 		vector< vector< vector<double> > >& phi){ // 2pi h^-3 c^-4 phi0 delta(E^3/3)/deltaE [group in][group out] units 1/cm/erg
 
@@ -388,9 +549,8 @@ void nulib_get_epannihil_kernels(
 	//PRINT_ASSERT(nulibtable_nItemp,>,0);
 	PRINT_ASSERT(nulibID,>=,0);
 
-	// get the chemical potential
-	double mue = nulib_eos_mue(rho,temp,ye) * pc::ergs_to_MeV; // MeV
-	double eta = mue/temp_MeV;
+	// degeneracy parameter
+	double eta = mue*pc::ergs_to_MeV / temp_MeV;
 	eta = max(eta,pow(10.0,nulibtable_logIeta_min));
 	eta = min(eta,pow(10.0,nulibtable_logIeta_max));
 	PRINT_ASSERT(eta,<=,pow(10.0,nulibtable_logIeta_max));
@@ -403,7 +563,8 @@ void nulib_get_epannihil_kernels(
 	if(read_epannihil>0){
 		PRINT_ASSERT(temp_MeV,<=,pow(10.0,nulibtable_logItemp_max));
 		PRINT_ASSERT(temp_MeV,>=,pow(10.0,nulibtable_logItemp_min));
-		nulibtable_epannihil_single_species_range_energy_(&temp_MeV, &eta, &lns, (double*)phi_tmp,
+		if(nulib_use_kernel_cache) epannihil_kernel_cache.interpolate(temp_MeV, eta, lns, (double*)phi_tmp);
+		else nulibtable_epannihil_single_species_range_energy_(&temp_MeV, &eta, &lns, (double*)phi_tmp,
 				&ngroups, &ngroups, &n_legendre_coefficients);
 	}
 
@@ -426,6 +587,7 @@ void nulib_get_eas_arrays(
 		double rho,                     // g/cm^3
 		double temp,                    // K
 		double ye, int nulibID,
+		double mue,                     // erg, electron chemical potential (only used for inelastic kernels)
 		vector<double>& nut_absopac,    // cm^-1
 		vector<double>& nut_scatopac,   // cm^-1
 		vector< vector<double> >& scattering_phi0, // 2pi h^-3 c^-4 phi0 delta(E^3/3)/deltaE [group in][group out] units 1/cm Output.
@@ -436,6 +598,7 @@ void nulib_get_eas_arrays(
 	PRINT_ASSERT(ye,>=,0);
 	PRINT_ASSERT(ye,<=,1.0);
 	PRINT_ASSERT(nulibID,>=,0);
+	PRINT_ASSERT(nulib_table_preprocessed,==,0); // fortran has no copy of the table
 
 	int nvars    = nulibtable_number_easvariables;
 	int ngroups  = nulibtable_number_groups;
@@ -461,7 +624,7 @@ void nulib_get_eas_arrays(
 	ye = max(nulibtable_ye_min,ye);
 
 	// If the density or temperature are too low, just set everything to zero
-	if(log10(rho) < nulibtable_logrho_min || log10(temp_MeV) < nulibtable_logtemp_min)
+	if(nulib_below_eas_table(rho,temp))
 		for(int j=0; j<ngroups; j++){
 			nut_absopac [j] = 0;
 			nut_scatopac[j] = 0;
@@ -482,11 +645,302 @@ void nulib_get_eas_arrays(
 
 		// set inelastic kernels if they exist in the table
 		if(read_Ielectron)
-			nulib_get_iscatter_kernels(rho,temp,ye,nulibID,scattering_phi0,scattering_delta);
+			nulib_get_iscatter_kernels(temp,mue,nulibID,scattering_phi0,scattering_delta);
 	}
 }
 
 
+/*********************/
+/* nulib_init_native */
+/*********************/
+// Rearrange the fortran eas tables so that all groups of one species at one
+// (rho,T,Ye) point are contiguous. Only needs to be called once.
+void nulib_init_native(){
+	if(nulibtable_native_eas!=NULL) return;
+	PRINT_ASSERT(nulibtable_number_groups,>,0);
+	PRINT_ASSERT(nulibtable_number_species,>,0);
+	const size_t ng = nulibtable_number_groups;
+	const size_t ns = nulibtable_number_species;
+	const size_t nnodes = (size_t)nulibtable_nrho * nulibtable_ntemp * nulibtable_nye;
+	nulibtable_native_nvars = (read_delta ? 3 : 2);
+	const size_t nvars = nulibtable_native_nvars;
+	nulibtable_native_eas_storage.resize(nnodes*ns*nvars*ng);
+
+	#pragma omp parallel for
+	for(size_t node=0; node<nnodes; node++)
+		for(size_t s=0; s<ns; s++)
+			for(size_t g=0; g<ng; g++){
+				// fortran index (rho,temp,ye,species*group), rho fastest
+				const size_t fortran_index = node + nnodes*(s*ng + g);
+				double* out = &nulibtable_native_eas_storage[(node*ns + s)*nvars*ng + g];
+				out[0   ] = nulibtable_absopacity [fortran_index];
+				out[  ng] = nulibtable_scatopacity[fortran_index];
+				if(read_delta) out[2*ng] = nulibtable_delta[fortran_index];
+			}
+
+	int my_rank=-1;
+	MPI_Comm_rank( MPI_COMM_WORLD, &my_rank );
+	nulibtable_native_eas = &nulibtable_native_eas_storage[0];
+	if(my_rank==0) cout << "#   native eas table: " << nulibtable_native_eas_storage.size()*sizeof(double)/1024./1024. << " MB" << endl;
+}
+
+/*******************************/
+/* nulib_get_eas_arrays_native */
+/*******************************/
+// Same result as nulib_get_eas_arrays (without the inelastic kernels), but
+// done in C++ for a batch of n zones without calling into fortran or
+// allocating memory. Trilinear in (log rho, log T, Ye) like NuLib, assuming
+// uniformly spaced table points. Group g of zone i is written to
+// absopac[stride*(i*ngroups+g)] and scatopac[stride*(i*ngroups+g)].
+void nulib_get_eas_arrays_native(const size_t n, const double* rho, const double* temp, const double* ye,
+		const int nulibID, double* absopac, double* scatopac, const size_t stride){
+	PRINT_ASSERT(nulibtable_native_eas,!=,(const double*)NULL);
+	PRINT_ASSERT(nulibID,>=,0);
+	PRINT_ASSERT(nulibID,<,nulibtable_number_species);
+	const size_t ng = nulibtable_number_groups;
+	const size_t ns = nulibtable_number_species;
+	const size_t nvars = nulibtable_native_nvars;
+	const int nx[3] = {nulibtable_nrho, nulibtable_ntemp, nulibtable_nye};
+	const double* xt[3] = {nulibtable_logrho, nulibtable_logtemp, nulibtable_ye};
+
+	for(size_t i=0; i<n; i++){
+		PRINT_ASSERT(rho[i],>=,0);
+		PRINT_ASSERT(temp[i],>=,0);
+		double* a = absopac  + stride*i*ng;
+		double* s = scatopac + stride*i*ng;
+
+		// If the density or temperature are too low, just set everything to zero
+		if(nulib_below_eas_table(rho[i], temp[i])){
+			for(size_t g=0; g<ng; g++) a[stride*g] = s[stride*g] = 0;
+			continue;
+		}
+
+		// lower cell index and fractional position in each direction.
+		// Outside the table the edge cell is extrapolated linearly.
+		const double x[3] = {log10(rho[i]), log10(temp[i]*pc::k_MeV), max(nulibtable_ye_min, min(nulibtable_ye_max, ye[i]))};
+		int ix[3];
+		double f[3];
+		for(size_t d=0; d<3; d++){
+			const double dx = (xt[d][nx[d]-1] - xt[d][0]) / (double)(nx[d]-1);
+			ix[d] = max(0, min(nx[d]-2, (int)floor((x[d]-xt[d][0]) / dx)));
+			f[d] = (x[d] - xt[d][ix[d]]) / dx;
+		}
+
+		// the eight corners of the cell
+		const double* corner[8];
+		double w[8];
+		for(size_t c=0; c<8; c++){
+			size_t node = 0, stride_node = 1;
+			w[c] = 1;
+			for(size_t d=0; d<3; d++){
+				const size_t right = (c>>d) & 1;
+				node += (ix[d] + right) * stride_node;
+				stride_node *= nx[d];
+				w[c] *= (right ? f[d] : 1.-f[d]);
+			}
+			corner[c] = &nulibtable_native_eas[(node*ns + nulibID)*nvars*ng];
+		}
+
+		// interpolate all groups at once
+		#pragma omp simd
+		for(size_t g=0; g<ng; g++){
+			double la=0, ls=0, d=0;
+			for(size_t c=0; c<8; c++){
+				la += w[c] * corner[c][g     ];
+				ls += w[c] * corner[c][g+  ng];
+				if(nvars==3) d += w[c] * corner[c][g+2*ng];
+			}
+			a[stride*g] = pow(10.,la);
+			s[stride*g] = pow(10.,ls) * (1. - d/3.);
+		}
+	}
+}
+
+/**********************/
+/* Preprocessed table */
+/**********************/
+// Everything the C++ side needs from a NuLib table (axes, the rearranged eas
+// table and the kernels at every (T,eta) node) in one flat file that is
+// mmapped read-only, so all ranks on a node share one copy in the page cache
+// and nothing has to be parsed at startup. Sections are 64-byte aligned and
+// stored in the native byte order of the machine that wrote them.
+const char nulib_preprocessed_magic[8] = {'S','D','N','U','L','I','B','\0'};
+const int nulib_preprocessed_version = 1;
+enum NuLibPreprocessedSection {sec_energies, sec_ewidths, sec_ebottom, sec_etop, sec_logrho, sec_logtemp, sec_ye,
+	sec_logItemp, sec_logIeta, sec_native_eas, sec_inelastic, sec_epannihil, n_preprocessed_sections};
+struct NuLibPreprocessedHeader{
+	char magic[8];
+	int version;
+	int number_species, number_easvariables, number_groups, nrho, ntemp, nye, nItemp, nIeta;
+	int read_Ielectron, read_epannihil, read_delta, native_nvars;
+	double logtemp_min, logtemp_max, logrho_min, logrho_max, ye_min, ye_max;
+	double logItemp_min, logItemp_max, logIeta_min, logIeta_max;
+	size_t offset[n_preprocessed_sections]; // bytes from the start of the file
+	size_t count[n_preprocessed_sections];  // number of doubles
+	size_t file_size;
+};
+
+bool nulib_is_preprocessed_table(const string filename){
+	char magic[8];
+	ifstream infile(filename.c_str(), ios::binary);
+	if(!infile.read(magic,8)) return false;
+	return memcmp(magic, nulib_preprocessed_magic, 8)==0;
+}
+
+bool nulib_using_preprocessed_table(){
+	return nulib_table_preprocessed;
+}
+
+// call after nulib_init has read an hdf5 table
+void nulib_write_preprocessed_table(const string filename){
+	PRINT_ASSERT(nulib_table_preprocessed,==,0);
+	nulib_init_native();
+	if(read_Ielectron or read_epannihil) nulib_init_kernel_cache();
+
+	NuLibPreprocessedHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, nulib_preprocessed_magic, 8);
+	header.version             = nulib_preprocessed_version;
+	header.number_species      = nulibtable_number_species;
+	header.number_easvariables = nulibtable_number_easvariables;
+	header.number_groups       = nulibtable_number_groups;
+	header.nrho                = nulibtable_nrho;
+	header.ntemp               = nulibtable_ntemp;
+	header.nye                 = nulibtable_nye;
+	header.nItemp              = nulibtable_nItemp;
+	header.nIeta               = nulibtable_nIeta;
+	header.read_Ielectron      = read_Ielectron;
+	header.read_epannihil      = read_epannihil;
+	header.read_delta          = read_delta;
+	header.native_nvars        = nulibtable_native_nvars;
+	header.logtemp_min         = nulibtable_logtemp_min;
+	header.logtemp_max         = nulibtable_logtemp_max;
+	header.logrho_min          = nulibtable_logrho_min;
+	header.logrho_max          = nulibtable_logrho_max;
+	header.ye_min              = nulibtable_ye_min;
+	header.ye_max              = nulibtable_ye_max;
+	header.logItemp_min        = nulibtable_logItemp_min;
+	header.logItemp_max        = nulibtable_logItemp_max;
+	header.logIeta_min         = nulibtable_logIeta_min;
+	header.logIeta_max         = nulibtable_logIeta_max;
+
+	const bool have_kernels = (nulibtable_nItemp>0 and nulibtable_nIeta>0);
+	const double* data[n_preprocessed_sections] = {nulibtable_energies, nulibtable_ewidths, nulibtable_ebottom, nulibtable_etop,
+			nulibtable_logrho, nulibtable_logtemp, nulibtable_ye, nulibtable_logItemp, nulibtable_logIeta,
+			nulibtable_native_eas, NULL, NULL};
+	const size_t ng = nulibtable_number_groups;
+	header.count[sec_energies] = header.count[sec_ewidths] = header.count[sec_ebottom] = header.count[sec_etop] = ng;
+	header.count[sec_logrho]     = nulibtable_nrho;
+	header.count[sec_logtemp]    = nulibtable_ntemp;
+	header.count[sec_ye]         = nulibtable_nye;
+	header.count[sec_logItemp]   = have_kernels ? nulibtable_nItemp : 0;
+	header.count[sec_logIeta]    = have_kernels ? nulibtable_nIeta  : 0;
+	header.count[sec_native_eas] = nulibtable_native_eas_storage.size();
+	header.count[sec_inelastic]  = read_Ielectron ? inelastic_kernel_cache.nnodes()*inelastic_kernel_cache.node_size() : 0;
+	header.count[sec_epannihil]  = read_epannihil ? epannihil_kernel_cache.nnodes()*epannihil_kernel_cache.node_size() : 0;
+	const size_t alignment = 64;
+	size_t offset = sizeof(header);
+	for(size_t i=0; i<n_preprocessed_sections; i++){
+		offset = (offset + alignment-1) / alignment * alignment;
+		header.offset[i] = offset;
+		offset += header.count[i]*sizeof(double);
+	}
+	header.file_size = offset;
+
+	ofstream outfile(filename.c_str(), ios::binary);
+	if(!outfile.good()){
+		cout << "ERROR: could not open " << filename << " for writing" << endl;
+		exit(1);
+	}
+	const char padding[alignment] = {0};
+	outfile.write((const char*)&header, sizeof(header));
+	for(size_t i=0; i<n_preprocessed_sections; i++){
+		const size_t npad = header.offset[i] - outfile.tellp();
+		PRINT_ASSERT(npad,<,alignment);
+		outfile.write(padding, npad);
+		if(header.count[i]==0) continue;
+		if(i==sec_inelastic)      inelastic_kernel_cache.write(outfile);
+		else if(i==sec_epannihil) epannihil_kernel_cache.write(outfile);
+		else outfile.write((const char*)data[i], header.count[i]*sizeof(double));
+	}
+	PRINT_ASSERT((size_t)outfile.tellp(),==,header.file_size);
+	outfile.close();
+}
+
+// map a file written by nulib_write_preprocessed_table and point the table globals into it
+void nulib_init_preprocessed(const string filename){
+	int fd = open(filename.c_str(), O_RDONLY);
+	struct stat file_stat;
+	if(fd<0 or fstat(fd,&file_stat)!=0){
+		cout << "ERROR: could not open " << filename << endl;
+		exit(1);
+	}
+	void* map = mmap(NULL, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map==MAP_FAILED){
+		cout << "ERROR: could not mmap " << filename << endl;
+		exit(1);
+	}
+	const NuLibPreprocessedHeader& header = *(const NuLibPreprocessedHeader*)map;
+	if(memcmp(header.magic, nulib_preprocessed_magic, 8)!=0 or header.version!=nulib_preprocessed_version or header.file_size!=(size_t)file_stat.st_size){
+		cout << "ERROR: " << filename << " is not a valid preprocessed NuLib table (version " << nulib_preprocessed_version << ")" << endl;
+		exit(1);
+	}
+	double* data[n_preprocessed_sections];
+	for(size_t i=0; i<n_preprocessed_sections; i++)
+		data[i] = header.count[i]>0 ? (double*)((char*)map + header.offset[i]) : NULL;
+
+	nulibtable_number_species      = header.number_species;
+	nulibtable_number_easvariables = header.number_easvariables;
+	nulibtable_number_groups       = header.number_groups;
+	nulibtable_nrho                = header.nrho;
+	nulibtable_ntemp               = header.ntemp;
+	nulibtable_nye                 = header.nye;
+	nulibtable_nItemp              = header.nItemp;
+	nulibtable_nIeta               = header.nIeta;
+	nulibtable_energies            = data[sec_energies];
+	nulibtable_ewidths             = data[sec_ewidths];
+	nulibtable_ebottom             = data[sec_ebottom];
+	nulibtable_etop                = data[sec_etop];
+	nulibtable_logrho              = data[sec_logrho];
+	nulibtable_logtemp             = data[sec_logtemp];
+	nulibtable_ye                  = data[sec_ye];
+	nulibtable_logItemp            = data[sec_logItemp];
+	nulibtable_logIeta             = data[sec_logIeta];
+	nulibtable_absopacity          = NULL;
+	nulibtable_scatopacity         = NULL;
+	nulibtable_delta               = NULL;
+	nulibtable_logtemp_min         = header.logtemp_min;
+	nulibtable_logtemp_max         = header.logtemp_max;
+	nulibtable_logrho_min          = header.logrho_min;
+	nulibtable_logrho_max          = header.logrho_max;
+	nulibtable_ye_min              = header.ye_min;
+	nulibtable_ye_max              = header.ye_max;
+	nulibtable_logItemp_min        = header.logItemp_min;
+	nulibtable_logItemp_max        = header.logItemp_max;
+	nulibtable_logIeta_min         = header.logIeta_min;
+	nulibtable_logIeta_max         = header.logIeta_max;
+	read_Ielectron                 = header.read_Ielectron;
+	read_epannihil                 = header.read_epannihil;
+	read_delta                     = header.read_delta;
+
+	nulibtable_native_nvars = header.native_nvars;
+	nulibtable_native_eas = data[sec_native_eas];
+	inelastic_kernel_cache.mapped_nodes = data[sec_inelastic];
+	epannihil_kernel_cache.mapped_nodes = data[sec_epannihil];
+	nulib_use_kernel_cache = 1;
+	nulib_table_preprocessed = 1;
+}
+
+bool nulib_has_inelastic_kernels(){
+	return read_Ielectron;
+}
+
+// opacities are set to zero below the table's density or temperature range
+bool nulib_below_eas_table(const double rho /* g/ccm */, const double temp /* K */){
+	return log10(rho) < nulibtable_logrho_min || log10(temp*pc::k_MeV) < nulibtable_logtemp_min;
+}
+
 /*********************/
 /* nulib_get_nu_grid */
 /*********************/
@@ -558,12 +1012,17 @@ void nulib_eos_read_table(char* eos_filename){
 	nulib_set_globals();
 }
 
-double nulib_eos_munue(const double rho /* g/ccm */, const double temp /* K */, const double ye){ // erg
+// both chemical potentials from a single EOS call
+void nulib_eos_chemical_potentials(const double rho /* g/ccm */, const double temp /* K */, const double ye,
+		double& mue /* erg */, double& munue /* erg */){
 	PRINT_ASSERT(rho,>=,0);
 	PRINT_ASSERT(temp,>=,0);
 	PRINT_ASSERT(ye,>=,0);
 	PRINT_ASSERT(ye,<=,1);
-	if(!nulib_in_range(rho,temp,ye)) return 0.0;
+	if(!nulib_in_range(rho,temp,ye)){
+		mue = 0;
+		munue = 0;
+	}
 	else{
 		double eos_variables[nulib_total_eos_variables];
 		for(int i=0; i<nulib_total_eos_variables; i++) eos_variables[i] = 0;
@@ -572,30 +1031,24 @@ double nulib_eos_munue(const double rho /* g/ccm */, const double temp /* K */,
 		eos_variables[2] = ye;
 
 		set_eos_variables_(eos_variables);
-		double mue = eos_variables[10];
+		double mue_MeV = eos_variables[10];
 		double muhat = eos_variables[13];
 
-		return (mue-muhat)*pc::MeV_to_ergs;
+		mue = mue_MeV*pc::MeV_to_ergs;
+		munue = (mue_MeV-muhat)*pc::MeV_to_ergs;
 	}
 }
 
-double nulib_eos_mue(const double rho /* g/ccm */, const double temp /* K */, const double ye){ // erg
-	PRINT_ASSERT(rho,>=,0);
-	PRINT_ASSERT(temp,>=,0);
-	PRINT_ASSERT(ye,>=,0);
-	PRINT_ASSERT(ye,<=,1);
-	if(!nulib_in_range(rho,temp,ye)) return 0.0;
-	else{
-		double eos_variables[nulib_total_eos_variables];
-		for(int i=0; i<nulib_total_eos_variables; i++) eos_variables[i] = 0;
-		eos_variables[0] = rho;
-		eos_variables[1] = temp * pc::k_MeV;
-		eos_variables[2] = ye;
+double nulib_eos_munue(const double rho /* g/ccm */, const double temp /* K */, const double ye){ // erg
+	double mue, munue;
+	nulib_eos_chemical_potentials(rho,temp,ye,mue,munue);
+	return munue;
+}
 
-		set_eos_variables_(eos_variables);
-		double mue = eos_variables[10];
-		return mue*pc::MeV_to_ergs;
-	}
+double nulib_eos_mue(const double rho /* g/ccm */, const double temp /* K */, const double ye){ // erg
+	double mue, munue;
+	nulib_eos_chemical_potentials(rho,temp,ye,mue,munue);
+	return mue;
 }
 
 
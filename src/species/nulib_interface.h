@@ -37,11 +37,23 @@ using namespace std;
 // returns everything in standard CGS units (i.e. ergs, s, cm, K, Hz)
 
 void nulib_init(string filename);
-void nulib_get_eas_arrays(double rho, double temp, double ye, int nulibID,
+void nulib_get_eas_arrays(double rho, double temp, double ye, int nulibID, double mue,
 		vector<double>& nut_absopac, vector<double>& nut_scatopac,
 		vector< vector<double> >& phi0, vector< vector<double> >& phi1_phi0);
+void nulib_init_native();
+void nulib_init_kernel_cache();
+bool nulib_is_preprocessed_table(const string filename);
+bool nulib_using_preprocessed_table();
+void nulib_init_preprocessed(const string filename);
+void nulib_write_preprocessed_table(const string filename);
+void nulib_get_eas_arrays_native(const size_t n, const double* rho, const double* temp, const double* ye,
+		const int nulibID, double* absopac, double* scatopac, const size_t stride);
+bool nulib_has_inelastic_kernels();
+bool nulib_below_eas_table(const double rho, const double temp);
+void nulib_get_iscatter_kernels(const double temp, const double mue, const int nulibID,
+		vector< vector<double> >& partial_opac, vector< vector<double> >& scattering_delta);
 void nulib_get_epannihil_kernels(
-		const double rho, const double temp, const double ye, const int nulibID,
+		const double temp, const double mue, const int nulibID,
 		vector< vector< vector<double> > >& phi);
 void nulib_get_nu_grid(Axis& nut_nu_grid);
 int nulib_get_nspecies();
@@ -57,6 +69,7 @@ bool nulib_in_range(double rho /* g/ccm */, double temp /* K */, double ye);
 void   nulib_eos_read_table(char* eos_filename);
 double nulib_eos_munue(const double rho, const double temp, const double ye);
 double nulib_eos_mue(const double rho, const double temp, const double ye);
+void   nulib_eos_chemical_potentials(const double rho, const double temp, const double ye, double& mue, double& munue);
 
 void nulib_get_rho_array(vector<double>& array);
 void nulib_get_T_array(vector<double>& array);
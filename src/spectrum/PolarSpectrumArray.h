@@ -238,8 +238,7 @@ public:
 		size_t stop = start + nphi*nmu;
 		double tmp = E / (double)(nphi*nmu);
 
-		#pragma omp critical
-		for(size_t i=start; i<stop; i++) data[i] += tmp;
+		for(size_t i=start; i<stop; i++) data[i] += tmp; // each element is atomic
 	}
 	double total() const{
 		double result=0;
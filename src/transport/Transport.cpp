@@ -29,6 +29,7 @@
 #include <mpi.h>
 #include <iostream>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 #include <string>
 #include "physical_constants.h"
@@ -50,6 +51,29 @@
 using namespace std;
 namespace pc = physical_constants;
 
+// 64-bit FNV-1a, used to fingerprint the inputs of the opacity cache
+static unsigned long long hash_bytes(const void* data, const size_t n, unsigned long long h=14695981039346656037ULL){
+	const unsigned char* c = (const unsigned char*)data;
+	for(size_t i=0; i<n; i++){
+		h ^= c[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+static unsigned long long hash_file(const string filename, unsigned long long h){
+	ifstream infile(filename.c_str(), ios::binary);
+	if(!infile.good()){
+		cout << "ERROR: could not open " << filename << " to hash it" << endl;
+		exit(1);
+	}
+	vector<char> buffer(1<<20);
+	while(infile){
+		infile.read(&buffer[0], buffer.size());
+		h = hash_bytes(&buffer[0], infile.gcount(), h);
+	}
+	return h;
+}
+
 // constructor
 Transport::Transport(){
 	verbose = -MAXLIM;
@@ -63,15 +87,25 @@ Transport::Transport(){
 	rho_max = NaN;
 	min_step_size = NaN;
 	max_step_size = NaN;
+	geodesic_tolerance = NaN;
 	do_randomwalk = -MAXLIM;
+	do_event_based = -MAXLIM;
+	do_streaming = -MAXLIM;
 	min_packet_weight = NaN;
+	do_weight_windows = -MAXLIM;
+	weight_window_ratio = NaN;
+	ww_emit_energy = NaN;
+	ww_emit_count = -MAXLIM;
 	do_annihilation = -MAXLIM;
 	grid = NULL;
 	r_core = NaN;
 	n_emit_core_per_bin = -MAXLIM;
 	n_emit_zones_per_bin = -MAXLIM;
+	n_emit_zones_total = -MAXLIM;
+	n_emit_zones_min_per_bin = -MAXLIM;
 	n_subcycles = -MAXLIM;
 	write_zones_every = -MAXLIM;
+	opacity_inputs_hash = 0;
 	particle_core_abs_energy = NaN;
 	particle_rouletted_energy = NaN;
 	particle_escape_energy = NaN;
@@ -109,21 +143,41 @@ void Transport::init(Lua* lua)
 	PRINT_ASSERT(n_subcycles,>=,1);
 	n_emit_zones_per_bin = lua->scalar<int>("n_emit_therm_per_bin");
 	n_emit_core_per_bin  = lua->scalar<int>("n_emit_core_per_bin");
+	n_emit_zones_total   = lua->scalar<int>("n_emit_therm_total");
+	if(n_emit_zones_total>0){
+		n_emit_zones_min_per_bin = lua->scalar<int>("n_emit_therm_min_per_bin");
+		PRINT_ASSERT(n_emit_zones_min_per_bin,>=,0);
+	}
 
 	// read simulation parameters
 	verbose      = MPI_myID==0 ? lua->scalar<int>("verbose") : 0;
 	do_annihilation = lua->scalar<int>("do_annihilation");
 	min_step_size     = lua->scalar<double>("min_step_size");
 	max_step_size     = lua->scalar<double>("max_step_size");
+	geodesic_tolerance = lua->scalar<double>("geodesic_tolerance");
 	do_randomwalk = lua->scalar<int>("do_randomwalk");
 	if(do_randomwalk){
 		randomwalk_min_optical_depth = lua->scalar<double>("randomwalk_min_optical_depth");
 		init_randomwalk_cdf(lua);
 	}
 	min_packet_weight = lua->scalar<double>("min_packet_weight");
+	do_weight_windows = lua->scalar<int>("do_weight_windows");
+	if(do_weight_windows){
+		weight_window_ratio = lua->scalar<double>("weight_window_ratio");
+		PRINT_ASSERT(weight_window_ratio,>,1);
+	}
+	do_event_based = lua->scalar<int>("do_event_based");
+	do_streaming = lua->scalar<int>("do_streaming");
 
 	// output parameters
 	write_zones_every   = lua->scalar<double>("write_zones_every");
+	opacity_cache_file  = lua->scalar<string>("opacity_cache_file");
+
+	// the Nagakura per-zone text files are not fingerprinted, so a cache made from them could go stale
+	if(opacity_cache_file.size()>0 and lua->scalar<string>("neutrino_type")=="Nagakura" and lua->scalar<string>("Nagakura_opacity_file").size()==0){
+		if(MPI_myID==0) cout << "ERROR: opacity_cache_file requires Nagakura_opacity_file. Convert opacity_dir with nagakura_opacity_convert." << endl;
+		exit(1);
+	}
 
 
 	//===================================//
@@ -196,6 +250,12 @@ void Transport::init(Lua* lua)
 		species_list.push_back(neutrinos_tmp);
 	}
 
+	//==========================//
+	// INITIALIZE THE NEUTRINOS //
+	//==========================//
+	// before the grid, which needs to know which species have analytic opacities
+	for(size_t i=0; i<species_list.size(); i++) species_list[i]->init(lua);
+
 
 	//=================//
 	// SET UP THE GRID //
@@ -237,13 +297,62 @@ void Transport::init(Lua* lua)
 	}
 
 	// setup and seed random number generator(s)
-	rangen.init();
+	rangen.init(lua->scalar<int>("rng_seed"));
+
+	// set up the thread-private tallies and particle batches
+	int nthreads = 1;
+	#ifdef _OPENMP
+	nthreads = omp_get_max_threads();
+	#endif
+	ZoneTally empty_slot;
+	empty_slot.z_ind = -1;
+	empty_slot.fourforce_abs = 0;
+	empty_slot.l_abs = 0;
+	empty_slot.ww_path = 0;
+	thread_tally.assign(nthreads, vector<ZoneTally>(THREAD_TALLY_SLOTS, empty_slot));
+	thread_batch.resize(nthreads);
+	for(int t=0; t<nthreads; t++) thread_batch[t].resize(PARTICLE_BATCH_SIZE);
+	if(verbose) cout << "#   Thread-private tallies: " << nthreads << "x" << THREAD_TALLY_SLOTS << " zones, "
+			<< nthreads*THREAD_TALLY_SLOTS*sizeof(ZoneTally)/1024./1024. << " MB" << endl;
+
+	// weight windows start out empty and are set after the first step
+	thread_split_bank.resize(nthreads);
+	if(do_weight_windows){
+		ww_center.set_axes(grid->xAxes);
+		ww_tally.set_axes(grid->xAxes);
+		ww_center.wipe();
+		ww_tally.wipe();
+		ww_emit_energy = 0;
+		ww_emit_count = 0;
+		thread_ww_emit_energy.assign(nthreads, 0);
+		thread_ww_emit_count.assign(nthreads, 0);
+	}
 
 
-	//==========================//
-	// INITIALIZE THE NEUTRINOS //
-	//==========================//
-	for(size_t i=0; i<species_list.size(); i++) species_list[i]->init(lua);
+	// fingerprint the opacity inputs other than the fluid
+	if(opacity_cache_file.size()>0){
+		string neutrino_type = lua->scalar<string>("neutrino_type");
+
+		// the tables can be large, so only rank 0 reads them
+		unsigned long long h = 0;
+		if(MPI_myID==0){
+			h = hash_bytes(neutrino_type.data(), neutrino_type.size());
+			if(neutrino_type=="NuLib"){
+				h = hash_file(lua->scalar<string>("nulib_table"), h);
+				h = hash_file(lua->scalar<string>("nulib_eos"), h);
+				int flags[2] = {lua->scalar<int>("nulib_native_interpolation"), lua->scalar<int>("nulib_kernel_cache")};
+				h = hash_bytes(flags, sizeof(flags), h);
+			}
+			else if(neutrino_type=="grey"){
+				double params[3] = {lua->scalar<double>("Neutrino_grey_opac"), lua->scalar<double>("Neutrino_grey_abs_frac"), lua->scalar<double>("Neutrino_grey_chempot")};
+				h = hash_bytes(params, sizeof(params), h);
+			}
+			else if(neutrino_type=="Nagakura")
+				h = hash_file(lua->scalar<string>("Nagakura_opacity_file"), h);
+		}
+		MPI_Bcast(&h, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+		opacity_inputs_hash = h;
+	}
 
 	// complain if we're not simulating anything
 	n_active.resize(species_list.size(),0);
@@ -315,10 +424,17 @@ void Transport::step()
 	// emit, propagate, and normalize. steady_state means no propagation time limit.
 	for(int i=0; i<n_subcycles; i++){
 	  if(verbose) cout << "# === Subcycle " << i+1 << "/" << n_subcycles << " ===" << endl;
-		emit_particles();
-		propagate_particles();
+		rangen.step++; // new random streams for every subcycle of every iteration
+		if(n_emit_zones_total>0) allocate_zone_emission();
+		if(do_streaming) emit_and_propagate();
+		else{
+			emit_particles();
+			propagate_particles();
+		}
+		merge_thread_tallies();
 	}
 	if(MPI_nprocs>1) sum_to_proc0();      // so each processor has necessary info to solve its zones
+	if(do_weight_windows) update_weight_windows();
 	normalize_radiative_quantities();
 
 	// calculate annihilation rates
@@ -339,6 +455,53 @@ void Transport::write(const int it) const{
 	}
 }
 
+//------------------------------------------------------------
+// add a buffered zone tally into the grid and empty the slot
+//------------------------------------------------------------
+void Transport::flush_zone_tally(ZoneTally& slot) const{
+	if(slot.z_ind < 0) return;
+	grid->fourforce_abs[slot.z_ind] += slot.fourforce_abs;
+	grid->l_abs[slot.z_ind] += slot.l_abs;
+	if(do_weight_windows) ww_tally[slot.z_ind] += slot.ww_path;
+	slot.z_ind = -1;
+	slot.fourforce_abs = 0;
+	slot.l_abs = 0;
+	slot.ww_path = 0;
+}
+
+//------------------------------------------------------------
+// this thread's tally slot for zone z_ind, evicting whatever
+// zone held it before. Particles stay in one neighbourhood for
+// many steps, so evictions (atomic adds) are rare.
+//------------------------------------------------------------
+Transport::ZoneTally& Transport::zone_tally(const int z_ind) const{
+	PRINT_ASSERT(z_ind,>=,0);
+	ZoneTally& slot = thread_tally[thread_num()][z_ind & (THREAD_TALLY_SLOTS-1)];
+	if(slot.z_ind != z_ind){
+		flush_zone_tally(slot);
+		slot.z_ind = z_ind;
+	}
+	return slot;
+}
+
+//------------------------------------------------------------
+// add the thread-private tallies into the grid and clear them
+//------------------------------------------------------------
+void Transport::merge_thread_tallies(){
+	const size_t nthreads = thread_tally.size();
+	#pragma omp parallel for collapse(2)
+	for(size_t t=0; t<nthreads; t++)
+		for(size_t i=0; i<THREAD_TALLY_SLOTS; i++)
+			flush_zone_tally(thread_tally[t][i]);
+
+	for(size_t t=0; t<thread_ww_emit_energy.size(); t++){
+		ww_emit_energy += thread_ww_emit_energy[t];
+		ww_emit_count += thread_ww_emit_count[t];
+		thread_ww_emit_energy[t] = 0;
+		thread_ww_emit_count[t] = 0;
+	}
+}
+
 //----------------------------
 // reset radiation quantities
 //------------------------------
@@ -365,12 +528,87 @@ void Transport::reset_radiation(){
 	particle_rouletted_energy = 0;
 	particle_escape_energy = 0;
 
-	if(verbose) cout << "# Setting zone transport quantities" << endl << flush;
+	// opacities only depend on the fluid state, so only recompute
+	// them in zones where rho, T, or Ye changed since the last call
+	const bool first_call = (grid->eas_fluid_state.size() != grid->rho.size());
+	unsigned long long cache_key = 0;
+	bool cache_loaded = false;
+	if(first_call){
+		Tuple<double,3> unset;
+		unset = NaN;
+		grid->eas_fluid_state.assign(grid->rho.size(), unset);
+
+		// an earlier run on the same inputs may have saved them
+		if(opacity_cache_file.size()>0){
+			cache_key = opacity_cache_key();
+			cache_loaded = grid->read_opacity_cache(opacity_cache_file, cache_key);
+			if(verbose) cout << "# " << (cache_loaded ? "Loaded" : "No usable") << " opacity cache " << opacity_cache_file << endl;
+		}
+		if(cache_loaded){
+			for(size_t z_ind=0; z_ind<grid->rho.size(); z_ind++){
+				grid->eas_fluid_state[z_ind][0] = grid->rho[z_ind];
+				grid->eas_fluid_state[z_ind][1] = grid->T[z_ind];
+				grid->eas_fluid_state[z_ind][2] = grid->Ye[z_ind];
+			}
+		}
+	}
+	vector<size_t> changed_zones;
+	for(size_t z_ind=0;z_ind<grid->rho.size();z_ind++){
+		const Tuple<double,3>& state = grid->eas_fluid_state[z_ind];
+		if(state[0]!=grid->rho[z_ind] || state[1]!=grid->T[z_ind] || state[2]!=grid->Ye[z_ind])
+			changed_zones.push_back(z_ind);
+	}
+
+	if(verbose) cout << "# Setting zone transport quantities in " << changed_zones.size() << "/" << grid->rho.size() << " zones" << endl << flush;
+	#pragma omp parallel for schedule(dynamic)
+	for(size_t i=0; i<changed_zones.size(); i++)
+		for(size_t s=0; s<species_list.size(); s++)
+			species_list[s]->set_eos(changed_zones[i],grid);
 	for(size_t s=0; s<species_list.size(); s++){
-		#pragma omp parallel for
-		for(size_t z_ind=0;z_ind<grid->rho.size();z_ind++)
-			species_list[s]->set_eas(z_ind,grid);
+		if(species_list[s]->analytic_opacities) continue;
+		#pragma omp parallel for schedule(dynamic)
+		for(size_t i=0; i<changed_zones.size(); i++)
+			species_list[s]->set_eas(changed_zones[i],grid);
+	}
+	if(first_call && !cache_loaded && verbose && grid->scattering_kernel[0].bandwidth < grid->nu_grid_axis.size()){
+		double truncated = 0;
+		for(size_t s=0; s<species_list.size(); s++)
+			truncated = max(truncated, grid->scattering_kernel[s].max_truncated_fraction.load());
+		cout << "#   Inelastic kernel bands drop at most " << truncated << " of a row's opacity" << endl;
+	}
+	for(size_t i=0; i<changed_zones.size(); i++){
+		const size_t z_ind = changed_zones[i];
+		grid->eas_fluid_state[z_ind][0] = grid->rho[z_ind];
+		grid->eas_fluid_state[z_ind][1] = grid->T[z_ind];
+		grid->eas_fluid_state[z_ind][2] = grid->Ye[z_ind];
+	}
+	if(first_call && opacity_cache_file.size()>0 && !cache_loaded && MPI_myID==0){
+		grid->write_opacity_cache(opacity_cache_file, cache_key);
+		if(verbose) cout << "# Wrote opacity cache " << opacity_cache_file << endl;
+	}
+}
+
+//-----------------------------------------------------------------
+// opacity_inputs_hash combined with the fluid state and the grids.
+// Used to decide whether an opacity cache file is still valid.
+//-----------------------------------------------------------------
+unsigned long long Transport::opacity_cache_key() const{
+	unsigned long long h = opacity_inputs_hash;
+	const size_t nspecies = species_list.size();
+	h = hash_bytes(&nspecies, sizeof(nspecies), h);
+	const size_t table_precision = sizeof(real);
+	h = hash_bytes(&table_precision, sizeof(table_precision), h);
+	for(size_t dir=0; dir<grid->xAxes.size(); dir++){
+		h = hash_bytes(&grid->xAxes[dir].min, sizeof(double), h);
+		h = hash_bytes(&grid->xAxes[dir].top[0], grid->xAxes[dir].top.size()*sizeof(double), h);
 	}
+	h = hash_bytes(&grid->nu_grid_axis.min, sizeof(double), h);
+	h = hash_bytes(&grid->nu_grid_axis.top[0], grid->nu_grid_axis.top.size()*sizeof(double), h);
+	h = hash_bytes(&grid->nu_grid_axis.mid[0], grid->nu_grid_axis.mid.size()*sizeof(double), h);
+	h = hash_bytes(&grid->rho.y0[0], grid->rho.size()*sizeof(double), h);
+	h = hash_bytes(&grid->T.y0[0],   grid->T.size()*sizeof(double), h);
+	h = hash_bytes(&grid->Ye.y0[0],  grid->Ye.size()*sizeof(double), h);
+	return h;
 }
 
 //-----------------------------
@@ -401,7 +639,7 @@ void Transport::calculate_annihilation(){
 		vector< vector< vector< vector<double> > > > phi; // [s][order][gin][gout]
 		phi.resize(species_list.size());
 		for(size_t s=0; s<species_list.size(); s++)
-			species_list[s]->get_annihil_kernels(grid->rho[z_ind], grid->T[z_ind], grid->Ye[z_ind], grid->nu_grid_axis, phi[s]);
+			species_list[s]->get_annihil_kernels(grid->rho[z_ind], grid->T[z_ind], grid->Ye[z_ind], grid->mue[z_ind], grid->nu_grid_axis, phi[s]);
 
 		// get the list of species
 		vector<Tuple<size_t,2> > pairs;
@@ -673,30 +911,113 @@ void Transport::update_eh_background(EinsteinHelper* eh) const{ // things that d
 	eh->set_tetrad_basis(grid->tetrad_rotation);
 }
 
-// make sure kup is consistent with the new background
-// interpolate reaction rates
-void Transport::update_eh_k_opac(EinsteinHelper* eh) const{
+// make sure kup is consistent with the new background and
+// find the particle in the frequency grid. Returns false if
+// the particle was absorbed instead.
+bool Transport::update_eh_k(EinsteinHelper* eh) const{
 	if(eh->kup[3] <= 0){
 		eh->fate = absorbed;
 		eh->z_ind = -1;
-		return;
+		return false;
 	}
 
 	PRINT_ASSERT(eh->kup,==,eh->kup);
 	eh->renormalize_kup();
 	eh->grid_coords[NDIMS] = min(eh->nu(), grid->nu_grid_axis.max());
 	eh->dir_ind[NDIMS] = min(grid->nu_grid_axis.bin(eh->nu()), (int)grid->nu_grid_axis.size()-1);
-	eh->eas_ind = grid->abs_opac[eh->s].direct_index(eh->dir_ind);
-	grid->abs_opac[eh->s].set_InterpolationCube(&(eh->icube_spec),eh->grid_coords,eh->dir_ind);
-	eh->absopac  =  grid->abs_opac[eh->s].interpolate(eh->icube_spec);
-	eh->scatopac = grid->scat_opac[eh->s].interpolate(eh->icube_spec);
-	eh->inelastic_scatopac = grid->inelastic_scat_opac[eh->s].interpolate(eh->icube_spec);
+	return true;
+}
+
+// make sure kup is consistent with the new background
+// interpolate reaction rates
+void Transport::update_eh_k_opac(EinsteinHelper* eh) const{
+	if(not update_eh_k(eh)) return;
+	const Species* species = species_list[eh->s];
+	if(species->analytic_opacities){
+		const double rho = grid->rho.interpolate(eh->icube_vol);
+		const double T   = grid->T.interpolate(eh->icube_vol);
+		const double Ye  = grid->Ye.interpolate(eh->icube_vol);
+		species->get_opacities(rho, T, Ye, eh->nu(), &eh->absopac, &eh->scatopac);
+		eh->inelastic_scatopac = 0;
+	}
+	else{
+		eh->eas_ind = grid->eas_opac[eh->s].direct_index(eh->dir_ind);
+		grid->eas_opac[eh->s].set_InterpolationCube(&(eh->icube_spec),eh->grid_coords,eh->dir_ind);
+		const Tuple<double,3> opac = grid->eas_opac[eh->s].interpolate(eh->icube_spec);
+		eh->absopac  = opac[iabs];
+		eh->scatopac = opac[iscat];
+		eh->inelastic_scatopac = opac[iinelastic];
+	}
 
 	PRINT_ASSERT(eh->absopac,>=,0);
 	PRINT_ASSERT(eh->scatopac,>=,0);
 	PRINT_ASSERT(eh->inelastic_scatopac,>=,0);
 }
 
+//------------------------------------------------------------
+// update_eh_k_opac() for the particles eh[list[0..n-1]].
+// The first pass finds each particle's interpolation cube and
+// copies its corners into [corner][particle] arrays. The
+// second adds up the tabulated opacities one corner at a time
+// with unit stride over the particles, in the same order as
+// MultiDArray::interpolate().
+//------------------------------------------------------------
+void Transport::update_batch_k_opac(EinsteinHelper* eh, const size_t* list, const size_t n) const{
+	PRINT_ASSERT(n,<=,PARTICLE_BATCH_SIZE);
+	const size_t ncorners = InterpolationCube<NDIMS+1>::ncorners;
+	size_t tabulated[PARTICLE_BATCH_SIZE];
+	const Tuple<real,3>* table[PARTICLE_BATCH_SIZE];
+	size_t corner_index[ncorners][PARTICLE_BATCH_SIZE];
+	double corner_weight[ncorners][PARTICLE_BATCH_SIZE];
+	double absopac[PARTICLE_BATCH_SIZE], scatopac[PARTICLE_BATCH_SIZE], inelastic_scatopac[PARTICLE_BATCH_SIZE];
+
+	// interpolation cubes. Analytic opacities are done right away. Particles
+	// move() rouletted still scatter, so they are updated like in move().
+	size_t ntab = 0;
+	for(size_t k=0; k<n; k++){
+		EinsteinHelper* p = &eh[list[k]];
+		if(p->fate != moving && p->fate != rouletted) continue;
+		if(species_list[p->s]->analytic_opacities){
+			update_eh_k_opac(p);
+			continue;
+		}
+		if(not update_eh_k(p)) continue;
+		const MultiDArray<real,3,NDIMS+1>& eas = grid->eas_opac[p->s];
+		p->eas_ind = eas.direct_index(p->dir_ind);
+		eas.set_InterpolationCube(&(p->icube_spec),p->grid_coords,p->dir_ind);
+		table[ntab] = &eas.y0.front();
+		for(size_t c=0; c<ncorners; c++){
+			PRINT_ASSERT(p->icube_spec.indices[c],<,eas.size());
+			corner_index[c][ntab] = p->icube_spec.indices[c];
+			corner_weight[c][ntab] = p->icube_spec.weights[c];
+		}
+		tabulated[ntab++] = list[k];
+	}
+
+	// interpolate
+	for(size_t k=0; k<ntab; k++) absopac[k] = scatopac[k] = inelastic_scatopac[k] = 0;
+	for(size_t c=0; c<ncorners; c++){
+		const size_t* index = corner_index[c];
+		const double* weight = corner_weight[c];
+		for(size_t k=0; k<ntab; k++){
+			const Tuple<real,3>& y = table[k][index[k]];
+			absopac[k]            += y[iabs]       * weight[k];
+			scatopac[k]           += y[iscat]      * weight[k];
+			inelastic_scatopac[k] += y[iinelastic] * weight[k];
+		}
+	}
+
+	for(size_t k=0; k<ntab; k++){
+		EinsteinHelper* p = &eh[tabulated[k]];
+		p->absopac = absopac[k];
+		p->scatopac = scatopac[k];
+		p->inelastic_scatopac = inelastic_scatopac[k];
+		PRINT_ASSERT(p->absopac,>=,0);
+		PRINT_ASSERT(p->scatopac,>=,0);
+		PRINT_ASSERT(p->inelastic_scatopac,>=,0);
+	}
+}
+
 
 // Randomly generate new direction isotropically in comoving frame
 void Transport::isotropic_direction(Tuple<double,3>& D, ThreadRNG *rangen){
@@ -778,3 +1099,86 @@ bool Transport::reject_direction(const double mu, const double delta) const{
 	if(rangen.uniform() > pdfval) return true;
 	else return false;
 }
+
+//-------------------------------------------------------------
+// Draw mu directly from the same PDF reject_direction accepts.
+// With x=(mu-min_mu)/(max_mu-min_mu) the CDF is (1-d)x + d x^2,
+// which is inverted in the form that is stable for small d.
+//-------------------------------------------------------------
+double Transport::sample_direction_cosine(const double delta, ThreadRNG *rangen){
+	if(delta==0) return 2.*rangen->uniform() - 1.;
+
+	double min_mu = delta> 1.0 ? delta-2. : -1.0;
+	double max_mu = delta<-1.0 ? delta+2. :  1.0;
+	double d = max(min(delta, 1.0), -1.0);
+	double U = rangen->uniform();
+	double denom = (1.-d) + sqrt((1.-d)*(1.-d) + 4.*d*U);
+	double x = denom>0 ? 2.*U / denom : 0;
+	PRINT_ASSERT(x,>=,0);
+	PRINT_ASSERT(x,<=,1.+TINY);
+	return min(min_mu + x*(max_mu-min_mu), max_mu);
+}
+
+// direction with the reject_direction PDF in the cosine of the angle to ref
+void Transport::sample_direction(Tuple<double,3>& D, const Tuple<double,3>& ref, const double delta, ThreadRNG *rangen){
+	double costheta = sample_direction_cosine(delta, rangen);
+	double sintheta = sqrt(max(0., 1. - costheta*costheta));
+	double phi = 2.*M_PI*rangen->uniform();
+
+	// orthonormal basis around the reference direction,
+	// starting from the axis least aligned with it
+	Tuple<double,3> z = ref;
+	Metric::normalize_Minkowski<3>(z);
+	size_t imin = 0;
+	for(size_t i=1; i<3; i++) if(fabs(z[i]) < fabs(z[imin])) imin = i;
+	Tuple<double,3> x;
+	for(size_t i=0; i<3; i++) x[i] = (i==imin ? 1. : 0.) - z[imin]*z[i];
+	Metric::normalize_Minkowski<3>(x);
+	Tuple<double,3> y;
+	y[0] = z[1]*x[2] - z[2]*x[1];
+	y[1] = z[2]*x[0] - z[0]*x[2];
+	y[2] = z[0]*x[1] - z[1]*x[0];
+
+	for(size_t i=0; i<3; i++) D[i] = costheta*z[i] + sintheta*(cos(phi)*x[i] + sin(phi)*y[i]);
+	Metric::normalize_Minkowski<3>(D);
+}
+
+void Transport::sample_kup_tet(Tuple<double,4>& kup_tet, const Tuple<double,4>& ref_kup_tet, const double delta, ThreadRNG *rangen){
+	PRINT_ASSERT(kup_tet[3],>,0);
+	Tuple<double,3> ref, D;
+	for(size_t i=0; i<3; i++) ref[i] = ref_kup_tet[i];
+	sample_direction(D,ref,delta,rangen);
+
+	kup_tet[0] = kup_tet[3] * D[0];
+	kup_tet[1] = kup_tet[3] * D[1];
+	kup_tet[2] = kup_tet[3] * D[2];
+
+	PRINT_ASSERT(Metric::dot_Minkowski<4>(kup_tet,kup_tet)/(kup_tet[3]*kup_tet[3]),<,TINY);
+}
+
+//-------------------------------------------------------------
+// Set a new direction with the reject_direction PDF in the cosine
+// of the angle to the coordinate radial direction. When there is
+// no shift and the tetrad's spatial legs are purely spatial (no
+// fluid velocity) the coordinate angle is the tetrad angle and mu
+// is drawn directly. Otherwise the PDF changes between the frames,
+// so fall back to rejection.
+//-------------------------------------------------------------
+void Transport::sample_radial_kup_tet(EinsteinHelper* eh, const double delta) const{
+	Tuple<double,4> kup_tet = eh->kup_tet;
+	const bool no_shift = !DO_GR or (eh->g.betaup[0]==0 and eh->g.betaup[1]==0 and eh->g.betaup[2]==0);
+	if(no_shift and eh->e[0][3]==0 and eh->e[1][3]==0 and eh->e[2][3]==0){
+		Tuple<double,4> xup = eh->xup;
+		xup[3] = 0;
+		sample_kup_tet(kup_tet, eh->coord_to_tetrad(xup), delta, &rangen);
+		eh->set_kup_tet(kup_tet);
+	}
+	else{
+		double costheta;
+		do{
+			isotropic_kup_tet(kup_tet,&rangen);
+			eh->set_kup_tet(kup_tet);
+			costheta = eh->g.dot<3>(eh->xup, eh->kup) / sqrt(eh->g.dot<3>(eh->kup, eh->kup) * eh->g.dot<3>(eh->xup, eh->xup));
+		} while(reject_direction(costheta, delta));
+	}
+}
@@ -29,7 +29,11 @@
 #define _TRANSPORT_H
 #include <vector>
 #include <atomic>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "Particle.h"
+#include "ParticleList.h"
 #include "LuaRead.h"
 #include "CDFArray.h"
 #include "ThreadRNG.h"
@@ -39,13 +43,23 @@ class Species;
 class Grid;
 enum ParticleEvent {elastic_scatter, randomwalk, nothing, inelastic_scatter};
 
+// number of particles propagated together by one thread
+#define PARTICLE_BATCH_SIZE 64
+
+// zones each thread buffers absorption tallies for (power of two)
+#define THREAD_TALLY_SLOTS 4096
+
+// most copies a particle is split into at one weight window check. Each
+// copy's stream phase gets one hex digit, so this must be at most 16.
+#define MAX_WEIGHT_WINDOW_SPLIT 16
+
 class Transport
 {
 
 protected:
 
 	// this species' list of particles
-	vector<Particle> particles;
+	ParticleList particles;
 
 	// MPI stuff
 	int MPI_nprocs;
@@ -62,18 +76,33 @@ protected:
 	// emit from where?
 	void emit_inner_source_by_bin();
 	void emit_zones_by_bin();
+	size_t n_emit_core_this_rank() const;
+	size_t n_emit_zones_this_rank() const;
+	void allocate_zone_emission();
 
 	// what kind of particle to create?
 	Particle create_surface_particle(const double Ep, const size_t s, const size_t g);
 	Particle create_thermal_particle(const int zone_index, const double weight, const size_t s, const size_t g);
+	Particle create_particle(const size_t id);
 
 	// propagate the particles
 	void propagate_particles();
 	void propagate(EinsteinHelper* eh);
-	void move(EinsteinHelper *eh, bool do_absorption=true) const;
+	void propagate_batch(EinsteinHelper* eh, const size_t nbatch);
+	void propagate_chunk(EinsteinHelper* batch, const size_t nbatch, const bool emitted);
+	void propagate_split_bank(EinsteinHelper* batch);
+	void count_emitted_particles(const EinsteinHelper* batch, const size_t nbatch);
+	void emit_and_propagate();
+	void finalize_particle(const EinsteinHelper* eh);
+	void move(EinsteinHelper *eh, bool do_absorption=true, bool update_opacities=true) const; // !update_opacities --> caller runs update_batch_k_opac
+	size_t geodesic_step(EinsteinHelper *eh, const double dlambda) const;
+	size_t integrate_geodesic_adaptive(EinsteinHelper *eh, const double dlambda) const;
+	Tuple<double,4> geodesic_acceleration(EinsteinHelper *work, const Tuple<double,4>& x, const Tuple<double,4>& k) const;
 	void random_walk(EinsteinHelper *eh) const;
 	void init_randomwalk_cdf(Lua* lua);
 	void window(EinsteinHelper *eh) const;
+	void weight_window(EinsteinHelper *eh);
+	void update_weight_windows();
 	void sample_scattering_final_state(EinsteinHelper* eh, const Tuple<double,4>& kup_tet_old) const;
 
 
@@ -84,6 +113,27 @@ protected:
 	// simulation parameters
 	int    do_annihilation;
 
+	// propagate with the event-based engine instead of one history at a time
+	int do_event_based;
+
+	// emit and propagate in chunks instead of storing all particles first
+	int do_streaming;
+
+	// pooled per-thread particle batches, reused every subcycle
+	vector<vector<EinsteinHelper> > thread_batch;
+
+	// weight windows on the comoving packet energy N*kup_tet[3], split above
+	// and rouletted below. Centers are generated from the previous step.
+	int do_weight_windows;
+	double weight_window_ratio; // upper/lower bound
+	ScalarMultiDArray<double,NDIMS> ww_center; // (zone) 0 --> no window yet
+	mutable ScalarMultiDArray<ATOMIC<double>,NDIMS> ww_tally; // (zone) energy-weighted path length
+	double ww_emit_energy; // comoving energy of the particles emitted this step
+	long ww_emit_count;
+	vector<double> thread_ww_emit_energy; // [thread], merged with the other tallies
+	vector<long> thread_ww_emit_count;
+	vector<vector<EinsteinHelper> > thread_split_bank; // split copies waiting to be propagated [thread]
+
 	// random walk parameters
 	CDFArray randomwalk_diffusion_time;
 	Axis randomwalk_xaxis;
@@ -95,6 +145,33 @@ protected:
 	// output parameters
 	int write_zones_every;
 
+	// opacities are saved to / loaded from this file ("" --> don't)
+	// and tagged with a hash of everything they were computed from
+	std::string opacity_cache_file;
+	unsigned long long opacity_inputs_hash;
+	unsigned long long opacity_cache_key() const;
+
+	// thread-private absorption tallies [thread][slot]. Zone z_ind uses slot
+	// z_ind%THREAD_TALLY_SLOTS, and the zone previously in that slot is added
+	// into the grid when it is evicted and at the end of each subcycle.
+	struct ZoneTally{
+		int z_ind; // -1 --> empty
+		Tuple<double,4> fourforce_abs;
+		double l_abs;
+		double ww_path; // added into ww_tally
+	};
+	mutable vector<vector<ZoneTally> > thread_tally;
+	ZoneTally& zone_tally(const int z_ind) const;
+	void flush_zone_tally(ZoneTally& slot) const;
+	void merge_thread_tallies();
+	static int thread_num(){
+		#ifdef _OPENMP
+		return omp_get_thread_num();
+		#else
+		return 0;
+		#endif
+	}
+
 	// global radiation quantities
 	ATOMIC<double> particle_rouletted_energy;
 	ATOMIC<double> particle_core_abs_energy;
@@ -124,6 +201,9 @@ public:
 	double min_packet_weight;
 	double min_step_size, max_step_size;
 
+	// geodesic integrator. <=0 --> leapfrog, >0 --> adaptive Dormand-Prince tolerance
+	double geodesic_tolerance;
+
 	// items for core emission
 	double r_core;
 	int n_emit_core_per_bin;
@@ -134,6 +214,12 @@ public:
 	void scatter(EinsteinHelper *eh, const ParticleEvent event) const;
 	int n_emit_zones_per_bin;
 
+	// emissivity-weighted zone emission (if n_emit_zones_total>0). Bins are
+	// (zone, species, group) in the same order as the fixed allocation.
+	int n_emit_zones_total, n_emit_zones_min_per_bin;
+	std::vector<size_t> zone_bin_start; // [bin] id of the bin's first particle, relative to the zone particles. Last entry is the total
+	std::vector<double> zone_bin_weight; // [bin] weight of each particle from the bin
+
 	// how many times do we emit+propagate each timestep?
 	int n_subcycles;
 
@@ -156,15 +242,24 @@ public:
 	static void isotropic_direction(Tuple<double,3>& D, ThreadRNG *rangen);
 	double R_randomwalk(const double kx_kttet, const double ux, const double dlab, const double D) const;
 	bool reject_direction(const double costheta, const double delta) const;
+	static double sample_direction_cosine(const double delta, ThreadRNG *rangen);
+	static void sample_direction(Tuple<double,3>& D, const Tuple<double,3>& ref, const double delta, ThreadRNG *rangen);
+	static void sample_kup_tet(Tuple<double,4>& kup_tet, const Tuple<double,4>& ref_kup_tet, const double delta, ThreadRNG *rangen);
+	void sample_radial_kup_tet(EinsteinHelper* eh, const double delta) const;
 
 	// set things up
 	void init(Lua* lua);
 	void update_eh_background(EinsteinHelper* eh) const;
+	bool update_eh_k(EinsteinHelper* eh) const;
 	void update_eh_k_opac(EinsteinHelper* eh) const;
+	void update_batch_k_opac(EinsteinHelper* eh, const size_t* list, const size_t n) const;
 
 	// in-simulation functions to be used by main
 	void step();
 	void which_event(const EinsteinHelper* eh, ParticleEvent *event, double* ds_com) const;
+	void which_event_batch(EinsteinHelper* eh, const size_t* list, const size_t n, ParticleEvent* event, double* ds_com) const;
+	void which_event_geometry(const EinsteinHelper* eh, ParticleEvent *event, double* ds_com) const;
+	double sample_optical_depth() const;
 	void reset_radiation();
 	void write(const int it) const;
 	void write_rays(const int it);
@@ -26,6 +26,7 @@
 */
 
 #include <omp.h>
+#include <algorithm>
 #include "Transport.h"
 #include "Species.h"
 #include "Grid.h"
@@ -42,51 +43,175 @@ void Transport::emit_particles()
 	// emit from the core and/or the zones
 	if(verbose) cout << "# Emitting particles..." << endl;
 	if(n_emit_core_per_bin>0 and r_core>0)  emit_inner_source_by_bin();
-	if(n_emit_zones_per_bin>0) emit_zones_by_bin();
+	if(n_emit_zones_per_bin>0 or n_emit_zones_total>0) emit_zones_by_bin();
 
 	// sanity checks
 	for(size_t i=0; i<particles.size(); i++){
-		if(particles[i].fate==moving){
+		if(particles.fate[i]==moving){
 			for(size_t j=0; j<4; j++){
-				PRINT_ASSERT(particles[i].xup[j],==,particles[i].xup[j]);
-				PRINT_ASSERT(particles[i].kup[j],==,particles[i].kup[j]);
+				PRINT_ASSERT(particles.xup[j][i],==,particles.xup[j][i]);
+				PRINT_ASSERT(particles.kup[j][i],==,particles.kup[j][i]);
 			}
-			PRINT_ASSERT(particles[i].N,==,particles[i].N);
+			PRINT_ASSERT(particles.N[i],==,particles.N[i]);
 		}
 	}
 }
 
 //------------------------------------------------------------
-// inject particles from a central luminous source
-// Currently written to emit photons with 
-// blackblody spectrum based on T_core and L_core
+// number of particles each source emits on this rank.
+// Particle ids are dealt out to the ranks round-robin.
 //------------------------------------------------------------
-void Transport::emit_inner_source_by_bin(){
-	int size_before = particles.size();
-	double weight = 1./((double)n_emit_core_per_bin);
+size_t Transport::n_emit_core_this_rank() const{
+	if(n_emit_core_per_bin<=0 or r_core<=0) return 0;
+	const size_t n_emit = species_list.size() * grid->nu_grid_axis.size() * n_emit_core_per_bin;
+	size_t n_emit_this_rank = n_emit / MPI_nprocs;
+	if((int)(n_emit % MPI_nprocs) > MPI_myID) n_emit_this_rank++;
+	return n_emit_this_rank;
+}
+size_t Transport::n_emit_zones_this_rank() const{
+	size_t n_emit = 0;
+	if(n_emit_zones_total>0) n_emit = zone_bin_start.back();
+	else if(n_emit_zones_per_bin>0) n_emit = species_list.size() * grid->nu_grid_axis.size() * grid->rho.size() * n_emit_zones_per_bin;
+	size_t n_emit_this_rank = n_emit / MPI_nprocs;
+	if((int)(n_emit % MPI_nprocs) > MPI_myID) n_emit_this_rank++;
+	return n_emit_this_rank;
+}
 
+//------------------------------------------------------------
+// Share n_emit_zones_total particles among the (zone, species,
+// group) bins in proportion to the energy each bin emits,
+// estimated at the zone center and group middle. A bin expecting
+// x particles gets floor(x) or floor(x)+1 of them at random, each
+// with weight 1/x, so the emission stays unbiased. Bins that would
+// get fewer than n_emit_zones_min_per_bin get exactly that many,
+// each with weight 1/n_emit_zones_min_per_bin. Bins that emit
+// nothing get no particles. Every rank draws the same numbers.
+//------------------------------------------------------------
+void Transport::allocate_zone_emission(){
 	const size_t ns = species_list.size();
 	const size_t ng = grid->nu_grid_axis.size();
-	const size_t n_emit = ns*ng*n_emit_core_per_bin;
-	size_t n_emit_this_rank = n_emit / MPI_nprocs;
-	if((int)(n_emit % MPI_nprocs) > MPI_myID) n_emit_this_rank++;
-	particles.resize(size_before + n_emit_this_rank);
+	const size_t nbins = grid->rho.size() * ns * ng;
 
-	size_t n_created = 0;
-	#pragma omp parallel for schedule(guided) collapse(3) reduction(+:n_created)
-	for(size_t s=0; s<ns; s++){
-		for(size_t g=0; g<ng; g++){
-			for(int k=0; k<n_emit_core_per_bin; k++){
-				size_t global_id = k + n_emit_core_per_bin*g + n_emit_core_per_bin*ng*s;
-				if((int)(global_id%MPI_nprocs) == MPI_myID){
-					size_t local_index = size_before + global_id/MPI_nprocs;
-					particles[local_index] = create_surface_particle(weight,s,g);
-					if(particles[local_index].fate == moving) n_created++;
+	// energy emitted from each bin (arbitrary units)
+	vector<double> emitted(nbins);
+	double total = 0;
+	#pragma omp parallel for reduction(+:total)
+	for(size_t z_ind=0; z_ind<grid->rho.size(); z_ind++){
+		size_t dir_ind[NDIMS+1];
+		grid->rho.indices(z_ind,dir_ind);
+		const double four_volume = grid->zone_4volume(z_ind);
+		for(size_t s=0; s<ns; s++){
+			const double mu = grid->munue[z_ind] * species_list[s]->lepton_number;
+			for(size_t g=0; g<ng; g++){
+				const double nu = grid->nu_grid_axis.mid[g];
+				double absopac, scatopac;
+				if(species_list[s]->analytic_opacities)
+					species_list[s]->get_opacities(grid->rho[z_ind], grid->T[z_ind], grid->Ye[z_ind], nu, &absopac, &scatopac);
+				else{
+					dir_ind[NDIMS] = g;
+					absopac = grid->eas_opac[s][grid->eas_opac[s].direct_index(dir_ind)][iabs];
 				}
+				const size_t bin = (z_ind*ns + s)*ng + g;
+				emitted[bin] = number_blackbody(grid->T[z_ind],mu,nu) * absopac * four_volume
+						* grid->nu_grid_axis.delta3(g) * nu * species_list[s]->weight;
+				PRINT_ASSERT(emitted[bin],>=,0);
+				total += emitted[bin];
 			}
 		}
 	}
 
+	// the same stream on every rank, separate from all particle streams
+	RandomStream stream;
+	rangen.start_stream(&stream, 0, 2);
+	zone_bin_start.resize(nbins+1);
+	zone_bin_weight.resize(nbins);
+	zone_bin_start[0] = 0;
+	size_t nonempty = 0;
+	for(size_t bin=0; bin<nbins; bin++){
+		const double x = total>0 ? n_emit_zones_total * emitted[bin] / total : 0;
+		size_t n = 0;
+		if(emitted[bin]<=0) zone_bin_weight[bin] = 0;
+		else if(x < n_emit_zones_min_per_bin){
+			n = n_emit_zones_min_per_bin;
+			zone_bin_weight[bin] = 1./(double)n;
+		}
+		else{
+			n = (size_t)x;
+			if(stream.uniform() < x-n) n++;
+			zone_bin_weight[bin] = 1./x;
+		}
+		if(n>0) nonempty++;
+		zone_bin_start[bin+1] = zone_bin_start[bin] + n;
+	}
+	if(verbose) cout << "#   allocate_zone_emission() gave " << zone_bin_start.back() << " particles to "
+			<< nonempty << "/" << nbins << " zone bins" << endl;
+}
+
+//------------------------------------------------------------
+// create the particle with the given global id. Core particles
+// come first, ordered by (species, group, sample), then the
+// zone particles ordered by (zone, species, group, sample).
+// With n_emit_zones_total>0 the zone bins hold different
+// numbers of particles, set by allocate_zone_emission().
+// Each particle draws from its own random stream, so the
+// result is independent of which thread or rank creates it.
+//------------------------------------------------------------
+Particle Transport::create_particle(const size_t id){
+	const size_t ns = species_list.size();
+	const size_t ng = grid->nu_grid_axis.size();
+	const size_t id_offset = ns*ng*max(n_emit_core_per_bin,0);
+
+	RandomStream stream;
+	rangen.start_stream(&stream, id, 0);
+	rangen.bind(&stream);
+	Particle p;
+	if(id < id_offset){
+		const size_t n = n_emit_core_per_bin;
+		const size_t g = (id/n) % ng;
+		const size_t s = id / (n*ng);
+		p = create_surface_particle(1./(double)n, s, g);
+	}
+	else{
+		const size_t zone_id = id - id_offset;
+		size_t bin;
+		double weight;
+		if(n_emit_zones_total>0){
+			bin = upper_bound(zone_bin_start.begin(), zone_bin_start.end(), zone_id) - zone_bin_start.begin() - 1;
+			weight = zone_bin_weight[bin];
+		}
+		else{
+			const size_t n = n_emit_zones_per_bin;
+			bin = zone_id/n;
+			weight = 1./(double)n;
+		}
+		const size_t g = bin % ng;
+		const size_t s = (bin/ng) % ns;
+		const size_t z_ind = bin / (ng*ns);
+		p = create_thermal_particle(z_ind, weight, s, g);
+	}
+	rangen.unbind();
+	p.id = id;
+	return p;
+}
+
+//------------------------------------------------------------
+// inject particles from a central luminous source
+// Currently written to emit photons with 
+// blackblody spectrum based on T_core and L_core
+//------------------------------------------------------------
+void Transport::emit_inner_source_by_bin(){
+	const size_t size_before = particles.size();
+	const size_t n_emit_this_rank = n_emit_core_this_rank();
+	particles.resize(size_before + n_emit_this_rank);
+
+	size_t n_created = 0;
+	#pragma omp parallel for schedule(guided) reduction(+:n_created)
+	for(size_t i=0; i<n_emit_this_rank; i++){
+		const size_t global_id = MPI_myID + i*MPI_nprocs;
+		particles.set(size_before+i, create_particle(global_id));
+		if(particles.fate[size_before+i] == moving) n_created++;
+	}
+
 	if(verbose) cout << "#   emit_inner_source_by_bin() created = " << n_created << " particles on rank 0 ("
 			<< n_emit_this_rank-n_created << " rouletted during emission)" << endl;
 }
@@ -96,36 +221,20 @@ void Transport::emit_inner_source_by_bin(){
 // emit particles
 //--------------------------------------------------------------------------
 void Transport::emit_zones_by_bin(){
-	int size_before = particles.size();
-	double weight = 1./((double)n_emit_zones_per_bin);
-
-	const size_t ns = species_list.size();
-	const size_t ng = grid->nu_grid_axis.size();
-	const size_t nz = grid->rho.size();
-	const size_t n_emit = ns*ng*nz*n_emit_zones_per_bin;
-	size_t n_emit_this_rank = n_emit / MPI_nprocs;
-	if((int)(n_emit % MPI_nprocs) > MPI_myID) n_emit_this_rank++;
+	const size_t size_before = particles.size();
+	const size_t id_offset = species_list.size()*grid->nu_grid_axis.size()*max(n_emit_core_per_bin,0); // core particles come first
+	const size_t n_emit_this_rank = n_emit_zones_this_rank();
 	particles.resize(size_before + n_emit_this_rank);
 
 	size_t n_created = 0;
-	#pragma omp parallel for reduction(+:n_created) schedule(guided) collapse(4)
-	for (size_t z_ind=0; z_ind<nz; z_ind++){
-		for(size_t s=0; s<ns; s++){
-			for(size_t g=0; g<ng; g++){
-				for(int k=0; k<n_emit_zones_per_bin; k++){
-
-					size_t global_id = k + n_emit_zones_per_bin*g + n_emit_zones_per_bin*ng*s + n_emit_zones_per_bin*ng*ns*z_ind;
-					if((int)(global_id%MPI_nprocs) == MPI_myID){
-						size_t local_index = size_before + global_id/MPI_nprocs;
-						particles[local_index] = create_thermal_particle(z_ind,weight,s,g);
-						if(particles[local_index].fate == moving){
-							n_created++;
-							for(size_t d=0; d<4; d++) PRINT_ASSERT(particles[local_index].xup[d],==,particles[local_index].xup[d]);
-						}
-					}
-
-				}
-			}
+	#pragma omp parallel for reduction(+:n_created) schedule(guided)
+	for(size_t i=0; i<n_emit_this_rank; i++){
+		const size_t global_id = id_offset + MPI_myID + i*MPI_nprocs;
+		const size_t local_index = size_before + i;
+		particles.set(local_index, create_particle(global_id));
+		if(particles.fate[local_index] == moving){
+			n_created++;
+			for(size_t d=0; d<4; d++) PRINT_ASSERT(particles.xup[d][local_index],==,particles.xup[d][local_index]);
 		}
 	}
 	  
@@ -236,12 +345,12 @@ Particle Transport::create_surface_particle(const double weight, const size_t s,
 	// sample outward direction
 	Tuple<double,4> kup_tet;
 	kup_tet[3] = nu * pc::h;
-	double costheta;
-	do{
+	eh.kup_tet = kup_tet;
+	if(r_core>0) sample_radial_kup_tet(&eh, 2.); // 2. makes pdf = costheta
+	else{
 		isotropic_kup_tet(kup_tet,&rangen);
 		eh.set_kup_tet(kup_tet);
-		costheta = eh.g.dot<3>(eh.xup, eh.kup) / sqrt(eh.g.dot<3>(eh.kup, eh.kup) * eh.g.dot<3>(eh.xup, eh.xup));
-	} while(r_core>0 and reject_direction(costheta, 2.)); // 2. makes pdf = costheta
+	}
 	update_eh_k_opac(&eh);
 
 	//get the number of neutrinos in the particle
@@ -42,54 +42,355 @@ void Transport::propagate_particles()
 	size_t ndone=0;
 	size_t last_percent = 0;
 	const size_t nparticles = particles.size();
+	const size_t nbatches = (nparticles + PARTICLE_BATCH_SIZE - 1) / PARTICLE_BATCH_SIZE;
 
 	//--- MOVE THE PARTICLES AROUND ---
-	#pragma omp parallel for schedule(dynamic)
-	for(size_t i=0; i<nparticles; i++){
-		if(particles[i].fate != moving){
-			#pragma omp atomic
-			ndone++;
-			continue;
-		}
+	#pragma omp parallel
+	{
+		// each thread reuses its own batch of EinsteinHelpers
+		EinsteinHelper* batch = &thread_batch[thread_num()].front();
+		size_t index[PARTICLE_BATCH_SIZE];
+
+		#pragma omp for schedule(dynamic)
+		for(size_t b=0; b<nbatches; b++){
+			const size_t start = b*PARTICLE_BATCH_SIZE;
+			const size_t stop = min(start+PARTICLE_BATCH_SIZE, nparticles);
+
+			// gather the live particles into the batch
+			size_t nbatch = 0;
+			for(size_t i=start; i<stop; i++){
+				if(particles.fate[i] != moving) continue;
+				index[nbatch] = i;
+				batch[nbatch].reset();
+				batch[nbatch].set_Particle(particles.get(i));
+				batch[nbatch].N0 = batch[nbatch].N;
+				rangen.start_stream(&batch[nbatch].rng, batch[nbatch].id, batch[nbatch].split_label);
+				nbatch++;
+			}
+			propagate_chunk(batch, nbatch, true);
 
-		// propagate each particle with an EinsteinHelper
-		EinsteinHelper eh;
-		eh.set_Particle(particles[i]);
-		eh.N0 = eh.N;
-		update_eh_background(&eh);
-		update_eh_k_opac(&eh);
-		propagate(&eh);
-
-		if(verbose){
-			#pragma omp atomic
-			ndone++;
-			size_t this_percent = (double)ndone/(double)nparticles*100.;
-			if(this_percent > last_percent){
-				last_percent = this_percent;
-				#pragma omp critical
-				cout << "\r"<<ndone<<"/"<<nparticles << " (" << last_percent<<"%)" << flush;
+			// scatter the results back into the particle list
+			for(size_t j=0; j<nbatch; j++){
+				PRINT_ASSERT(batch[j].fate, !=, moving);
+				particles.set(index[j], batch[j].get_Particle());
 			}
-		}
-		PRINT_ASSERT(eh.fate, !=, moving);
-		particles[i] = eh.get_Particle();
-	} //#pragma omp parallel for
+			propagate_split_bank(batch);
+
+			if(verbose){
+				#pragma omp atomic
+				ndone += stop-start;
+				size_t this_percent = (double)ndone/(double)nparticles*100.;
+				if(this_percent > last_percent){
+					last_percent = this_percent;
+					#pragma omp critical
+					cout << "\r"<<ndone<<"/"<<nparticles << " (" << last_percent<<"%)" << flush;
+				}
+			}
+		} //#pragma omp for
+	} //#pragma omp parallel
 	if(verbose) cout << endl;
 
 	// remove the dead particles, erase the memory
 	particles.resize(0);
 }
 
+//--------------------------------------------------------
+// Create particles and propagate them right away, one
+// chunk at a time, without storing the particle list.
+// Each thread only holds its own pooled batch, so memory
+// scales with the number of threads rather than the
+// number of particles.
+//--------------------------------------------------------
+void Transport::emit_and_propagate()
+{
+	if(verbose) cout << "# Emitting and propagating particles..." << endl;
+
+	const size_t n_core = n_emit_core_this_rank();
+	const size_t n_local = n_core + n_emit_zones_this_rank();
+	const size_t id_offset = species_list.size()*grid->nu_grid_axis.size()*max(n_emit_core_per_bin,0);
+	const size_t nchunks = (n_local + PARTICLE_BATCH_SIZE - 1) / PARTICLE_BATCH_SIZE;
+
+	size_t n_created = 0;
+	#pragma omp parallel reduction(+:n_created)
+	{
+		EinsteinHelper* batch = &thread_batch[thread_num()].front();
+
+		#pragma omp for schedule(dynamic)
+		for(size_t c=0; c<nchunks; c++){
+			const size_t start = c*PARTICLE_BATCH_SIZE;
+			const size_t stop = min(start+PARTICLE_BATCH_SIZE, n_local);
+
+			// emission kernel. Same ids as emit_particles(), so the histories are identical.
+			size_t nbatch = 0;
+			for(size_t i=start; i<stop; i++){
+				const size_t global_id = i<n_core ?
+						MPI_myID + i*MPI_nprocs :
+						id_offset + MPI_myID + (i-n_core)*MPI_nprocs;
+				Particle p = create_particle(global_id);
+				if(p.fate != moving) continue;
+				batch[nbatch].reset();
+				batch[nbatch].set_Particle(p);
+				batch[nbatch].N0 = batch[nbatch].N;
+				rangen.start_stream(&batch[nbatch].rng, global_id, batch[nbatch].split_label);
+				nbatch++;
+			}
+			n_created += nbatch;
+			propagate_chunk(batch, nbatch, true);
+			propagate_split_bank(batch);
+		} //#pragma omp for
+	} //#pragma omp parallel
+
+	if(verbose) cout << "#   emit_and_propagate() created " << n_created << " particles on rank 0 ("
+			<< n_local-n_created << " rouletted immediately)" << endl;
+}
+
+//--------------------------------------------------------
+// propagate a gathered batch of live particles with the
+// selected engine. All tallies are done by the end.
+// emitted --> the batch was just created rather than split
+//--------------------------------------------------------
+void Transport::propagate_chunk(EinsteinHelper* batch, const size_t nbatch, const bool emitted){
+	// background and opacity kernels
+	for(size_t j=0; j<nbatch; j++) update_eh_background(&batch[j]);
+	for(size_t j=0; j<nbatch; j++) update_eh_k_opac(&batch[j]);
+	if(emitted && do_weight_windows) count_emitted_particles(batch, nbatch);
+
+	if(do_event_based) propagate_batch(batch, nbatch);
+	else for(size_t j=0; j<nbatch; j++){
+		rangen.bind(&batch[j].rng);
+		propagate(&batch[j]);
+	}
+	rangen.unbind();
+}
+
+//--------------------------------------------------------
+// add a freshly emitted batch to this thread's emission
+// tallies, which normalize the weight windows. Uses the
+// comoving energy, which is what the windows act on.
+//--------------------------------------------------------
+void Transport::count_emitted_particles(const EinsteinHelper* batch, const size_t nbatch){
+	double e = 0;
+	for(size_t j=0; j<nbatch; j++) e += batch[j].N * batch[j].kup_tet[3];
+	thread_ww_emit_energy[thread_num()] += e;
+	thread_ww_emit_count[thread_num()] += nbatch;
+}
+
+//--------------------------------------------------------
+// propagate the copies made by weight window splitting,
+// refilling the batch from this thread's bank until it is
+// empty. Copies can split again.
+//--------------------------------------------------------
+void Transport::propagate_split_bank(EinsteinHelper* batch){
+	vector<EinsteinHelper>& bank = thread_split_bank[thread_num()];
+	while(bank.size()>0){
+		size_t nbatch = 0;
+		while(nbatch<PARTICLE_BATCH_SIZE and bank.size()>0){
+			batch[nbatch++] = bank.back();
+			bank.pop_back();
+		}
+		propagate_chunk(batch, nbatch, false);
+	}
+}
+
+//--------------------------------------------------------
+// Event-based propagation of a batch of particles. On each
+// sweep the live particles are sorted into queues by their
+// next event and each queue is processed in turn, so every
+// kernel runs the same code path over the whole queue.
+// Continues until all particles escape, are absorbed, or
+// are rouletted. The background and opacities must already
+// be set (see propagate_chunk).
+//--------------------------------------------------------
+void Transport::propagate_batch(EinsteinHelper* eh, const size_t nbatch){
+	PRINT_ASSERT(nbatch,<=,PARTICLE_BATCH_SIZE);
+	size_t active[PARTICLE_BATCH_SIZE];
+	size_t walk_queue[PARTICLE_BATCH_SIZE];
+	size_t move_queue[PARTICLE_BATCH_SIZE];
+	size_t elastic_queue[PARTICLE_BATCH_SIZE];
+	size_t inelastic_queue[PARTICLE_BATCH_SIZE];
+
+	for(size_t i=0; i<nbatch; i++){
+		PRINT_ASSERT(eh[i].fate, ==, moving);
+		n_active[eh[i].s]++;
+		active[i] = i;
+	}
+
+	size_t nactive = nbatch;
+	while(nactive > 0){
+
+		// event selection kernel. Sort particles into event queues.
+		for(size_t j=0; j<nactive; j++){
+			const EinsteinHelper* p = &eh[active[j]];
+			PRINT_ASSERT(p->z_ind,>=,0);
+			PRINT_ASSERT(p->N,>,0);
+			PRINT_ASSERT(p->N,<,1e99);
+			PRINT_ASSERT(p->kup[3],>,0);
+			PRINT_ASSERT(p->kup_tet[3],>,0);
+			PRINT_ASSERT(p->kup[3],<,INFINITY);
+			for(size_t d=0; d<NDIMS; d++) PRINT_ASSERT(p->dir_ind[d],<,grid->rho.axes[d].size());
+		}
+		ParticleEvent event[PARTICLE_BATCH_SIZE];
+		double ds_com[PARTICLE_BATCH_SIZE];
+		which_event_batch(eh, active, nactive, event, ds_com);
+		size_t nwalk=0, nmove=0, nelastic=0, ninelastic=0;
+		for(size_t j=0; j<nactive; j++){
+			const size_t i = active[j];
+			eh[i].ds_com = ds_com[j];
+			PRINT_ASSERT(eh[i].ds_com ,>, 0);
+
+			if(event[j]==randomwalk) walk_queue[nwalk++] = i;
+			else{
+				move_queue[nmove++] = i;
+				if(event[j]==elastic_scatter) elastic_queue[nelastic++] = i;
+				else if(event[j]==inelastic_scatter) inelastic_queue[ninelastic++] = i;
+			}
+		}
+
+		// random walk queue
+		for(size_t k=0; k<nwalk; k++){
+			rangen.bind(&eh[walk_queue[k]].rng);
+			random_walk(&eh[walk_queue[k]]);
+		}
+
+		// free streaming / boundary crossing queue, then
+		// the opacity kernel at the new positions
+		for(size_t k=0; k<nmove; k++){
+			rangen.bind(&eh[move_queue[k]].rng);
+			move(&eh[move_queue[k]], true, false);
+		}
+		update_batch_k_opac(eh, move_queue, nmove);
+
+		// elastic scattering queue
+		for(size_t k=0; k<nelastic; k++){
+			EinsteinHelper* p = &eh[elastic_queue[k]];
+			rangen.bind(&p->rng);
+			if(p->z_ind>=0) scatter(p, elastic_scatter);
+		}
+
+		// inelastic scattering queue
+		for(size_t k=0; k<ninelastic; k++){
+			EinsteinHelper* p = &eh[inelastic_queue[k]];
+			rangen.bind(&p->rng);
+			if(p->z_ind>=0) scatter(p, inelastic_scatter);
+		}
+
+		// roulette and weight window queue
+		for(size_t j=0; j<nactive; j++){
+			EinsteinHelper* p = &eh[active[j]];
+			rangen.bind(&p->rng);
+			if(p->fate==moving) window(p);
+			if(p->fate==moving and do_weight_windows) weight_window(p);
+			if(p->fate==moving) PRINT_ASSERT(abs(p->g.dot<4>(p->kup,p->kup)) / (p->kup[3]*p->kup[3]), <=, TINY);
+			PRINT_ASSERT(p->N,<,1e99);
+		}
+
+		// compact the list of live particles
+		size_t nstill = 0;
+		for(size_t j=0; j<nactive; j++)
+			if(eh[active[j]].fate == moving) active[nstill++] = active[j];
+		nactive = nstill;
+	}
+
+	// tally kernel
+	for(size_t i=0; i<nbatch; i++) finalize_particle(&eh[i]);
+}
+
 //--------------------------------------------------------
 // Decide what happens to the particle
 //--------------------------------------------------------
 void Transport::which_event(const EinsteinHelper *eh, ParticleEvent *event, double* ds_com) const{
+	which_event_geometry(eh, event, ds_com);
+
+	// FIND D_ELASTIC_SCATTER =================================================================
+	if(*event!=randomwalk && eh->scatopac>0){
+		const double d_interact = sample_optical_depth() / eh->scatopac;
+		if(d_interact < *ds_com){
+			*ds_com = d_interact;
+			*event = elastic_scatter;
+		}
+	}
+
+	// FIND D_INELASTIC_SCATTER =================================================================
+	if(*event!=randomwalk && eh->inelastic_scatopac>0){
+		const double d_inelastic_scatter = sample_optical_depth() / eh->inelastic_scatopac;
+		if(d_inelastic_scatter < *ds_com){
+			*ds_com = d_inelastic_scatter;
+			*event = inelastic_scatter;
+		}
+	}
+	PRINT_ASSERT(*ds_com, >=, 0);
+	PRINT_ASSERT(*ds_com, <, INFINITY);
+}
+
+//--------------------------------------------------------
+// which_event() for eh[list[0..n-1]]. The grid distances
+// and optical depths are found one particle at a time,
+// drawing random numbers in the same order as which_event().
+// Then one branch-free pass over [particle] arrays picks
+// the nearest event.
+//--------------------------------------------------------
+void Transport::which_event_batch(EinsteinHelper* eh, const size_t* list, const size_t n, ParticleEvent* event, double* ds_com) const{
+	PRINT_ASSERT(n,<=,PARTICLE_BATCH_SIZE);
+	double tau_elastic[PARTICLE_BATCH_SIZE], tau_inelastic[PARTICLE_BATCH_SIZE];
+	double scatopac[PARTICLE_BATCH_SIZE], inelastic_scatopac[PARTICLE_BATCH_SIZE];
+
+	// geometry and random numbers. Infinite optical depth --> no scattering.
+	for(size_t k=0; k<n; k++){
+		EinsteinHelper* p = &eh[list[k]];
+		rangen.bind(&p->rng);
+		which_event_geometry(p, &event[k], &ds_com[k]);
+		const bool can_scatter = (event[k] != randomwalk);
+		scatopac[k] = p->scatopac;
+		inelastic_scatopac[k] = p->inelastic_scatopac;
+		tau_elastic[k]   = (can_scatter && scatopac[k]>0)           ? sample_optical_depth() : INFINITY;
+		tau_inelastic[k] = (can_scatter && inelastic_scatopac[k]>0) ? sample_optical_depth() : INFINITY;
+	}
+
+	// nearest event
+	for(size_t k=0; k<n; k++){
+		const double d_interact = tau_elastic[k] / scatopac[k];
+		const double d_inelastic_scatter = tau_inelastic[k] / inelastic_scatopac[k];
+		const bool elastic = d_interact < ds_com[k];
+		double ds = elastic ? d_interact : ds_com[k];
+		ParticleEvent e = elastic ? elastic_scatter : event[k];
+		const bool inelastic = d_inelastic_scatter < ds;
+		ds_com[k] = inelastic ? d_inelastic_scatter : ds;
+		event[k] = inelastic ? inelastic_scatter : e;
+	}
+
+	for(size_t k=0; k<n; k++){
+		PRINT_ASSERT(ds_com[k], >=, 0);
+		PRINT_ASSERT(ds_com[k], <, INFINITY);
+	}
+}
+
+//--------------------------------------------------------
+// exponentially distributed optical depth to the next
+// interaction
+//--------------------------------------------------------
+double Transport::sample_optical_depth() const{
+	double tau;
+	do{
+		tau = -log(rangen.uniform());
+	} while(tau >= INFINITY);
+	return tau;
+}
+
+//--------------------------------------------------------
+// Distance to the zone size or grid boundary limit, or
+// the random walk sphere if the particle should walk
+//--------------------------------------------------------
+void Transport::which_event_geometry(const EinsteinHelper *eh, ParticleEvent *event, double* ds_com) const{
 	PRINT_ASSERT(eh->N, >, 0);
 	PRINT_ASSERT(eh->z_ind,>=,0);
 	*event = nothing;
 
 	// FIND D_ZONE= ====================================================================
 	double d_zone = grid->zone_min_length(eh->z_ind) / sqrt(Metric::dot_Minkowski<3>(eh->kup,eh->kup)) * eh->kup_tet[3];
-	d_zone = min(max(d_zone, d_zone*min_step_size), d_zone*max_step_size);
+	// the adaptive geodesic integrator controls its own error, so only
+	// limit the step to one zone length for the sake of the tallies
+	const double max_step = (DO_GR && geodesic_tolerance>0) ? max(max_step_size, 1.0) : max_step_size;
+	d_zone = min(max(d_zone, d_zone*min_step_size), d_zone*max_step);
 	PRINT_ASSERT(d_zone, >, 0);
 
 	// FIND D_BOUNDARY
@@ -123,39 +424,9 @@ void Transport::which_event(const EinsteinHelper *eh, ParticleEvent *event, doub
 			*event = randomwalk;
 		}
 	}
-
-	// FIND D_ELASTIC_SCATTER =================================================================
-	double d_interact = INFINITY;
-	if(*event!=randomwalk && eh->scatopac>0){
-		double tau;
-		do{
-			tau = -log(rangen.uniform());
-		} while(tau >= INFINITY);
-		d_interact = tau / eh->scatopac;
-		if(d_interact < *ds_com){
-			*ds_com = d_interact;
-			*event = elastic_scatter;
-		}
-	}
-
-	// FIND D_INELASTIC_SCATTER =================================================================
-	double d_inelastic_scatter = INFINITY;
-	if(*event!=randomwalk && eh->inelastic_scatopac>0){
-		double tau;
-		do{
-			tau = -log(rangen.uniform());
-		} while(tau >= INFINITY);
-		d_inelastic_scatter = tau / eh->inelastic_scatopac;
-		if(d_inelastic_scatter < *ds_com){
-			*ds_com = d_inelastic_scatter;
-			*event = inelastic_scatter;
-		}
-	}
-	PRINT_ASSERT(*ds_com, >=, 0);
-	PRINT_ASSERT(*ds_com, <, INFINITY);
 }
 
-void Transport::move(EinsteinHelper *eh, bool do_absorption) const{
+void Transport::move(EinsteinHelper *eh, bool do_absorption, bool update_opacities) const{
 	PRINT_ASSERT(eh->ds_com,>=,0);
 	PRINT_ASSERT(eh->N,>,0);
 	PRINT_ASSERT(abs(eh->g.dot<4>(eh->kup,eh->kup)) / (eh->kup[3]*eh->kup[3]), <=, TINY);
@@ -164,19 +435,10 @@ void Transport::move(EinsteinHelper *eh, bool do_absorption) const{
 	double dlambda = eh->ds_com / eh->kup_tet[3];
 	PRINT_ASSERT(dlambda,>=,0);
 
-	// kick 1
-	if(DO_GR) eh->kup += eh->dk_dlambda() * 0.5*dlambda;
-	const EinsteinHelper eh_old = *eh;
-
-	// drift
-	eh->xup += eh->kup * dlambda;
-	update_eh_background(eh);
-
-	// kick2
-	if(eh->fate==moving){
-		if(DO_GR) eh->kup += eh->dk_dlambda() * 0.5*dlambda;
-		update_eh_k_opac(eh);
-	}
+	// move along the geodesic. Only the particle state is needed afterward.
+	const EinsteinState eh_old = *eh;
+	geodesic_step(eh, dlambda);
+	if(eh->fate==moving and update_opacities) update_eh_k_opac(eh);
 
 
 	double tau=0, dN=0;
@@ -190,12 +452,13 @@ void Transport::move(EinsteinHelper *eh, bool do_absorption) const{
 		window(eh);
 
 		// store absorbed energy rate in *comoving* frame
-		grid->fourforce_abs[eh_old.z_ind] += eh_old.kup_tet * dN/eh_old.zone_fourvolume;
+		ZoneTally& tally = zone_tally(eh_old.z_ind);
+		tally.fourforce_abs += eh_old.kup_tet * dN/eh_old.zone_fourvolume;
 
 		// store absorbed lepton number (same in both frames, except for the
 		// factor of this_d which is divided out later
 		if(species_list[eh->s]->lepton_number != 0){
-			grid->l_abs[eh_old.z_ind] += dN * species_list[eh->s]->lepton_number / eh_old.zone_fourvolume;
+			tally.l_abs += dN * species_list[eh->s]->lepton_number / eh_old.zone_fourvolume;
 		}
 	}
 
@@ -203,9 +466,122 @@ void Transport::move(EinsteinHelper *eh, bool do_absorption) const{
 	// use old coordinates/directions to avoid problems with boundaries
 	double avg_N = (tau>TINY ? dN/tau : (eh->N+eh_old.N)/2.);
 	grid->distribution[eh_old.s]->count_single(eh_old.kup_tet, eh_old.dir_ind, avg_N*eh_old.ds_com*eh_old.kup_tet[3] / (eh_old.zone_fourvolume*pc::c));
-	
+
+	// energy-weighted path length for the next step's weight windows
+	if(do_weight_windows) zone_tally(eh_old.z_ind).ww_path += avg_N * eh_old.ds_com * eh_old.kup_tet[3];
+}
+
+
+//--------------------------------------------------------
+// Advance xup and kup by dlambda along the geodesic and
+// update the background. Returns the number of substeps.
+//--------------------------------------------------------
+size_t Transport::geodesic_step(EinsteinHelper *eh, const double dlambda) const{
+	if(DO_GR && geodesic_tolerance>0){
+		size_t nsteps = integrate_geodesic_adaptive(eh, dlambda);
+		update_eh_background(eh);
+		return nsteps;
+	}
+
+	// kick 1
+	if(DO_GR) eh->kup += eh->dk_dlambda() * 0.5*dlambda;
+
+	// drift
+	eh->xup += eh->kup * dlambda;
+	update_eh_background(eh);
+
+	// kick2
+	if(DO_GR && eh->fate==moving) eh->kup += eh->dk_dlambda() * 0.5*dlambda;
+	return 1;
+}
+
+// dk/dlambda at an arbitrary point. Only sets what the Christoffel symbols need.
+Tuple<double,4> Transport::geodesic_acceleration(EinsteinHelper *work, const Tuple<double,4>& x, const Tuple<double,4>& k) const{
+	Tuple<double,4> result;
+	work->xup = x;
+	work->z_ind = grid->zone_index(x);
+	if(work->z_ind<0){ // off the grid. Treat as flat; the particle is leaving anyway.
+		result = 0;
+		return result;
+	}
+	grid->grid_coordinates(x,work->grid_coords);
+	grid->rho.indices(work->z_ind, work->dir_ind);
+	grid->rho.set_InterpolationCube(&(work->icube_vol),work->grid_coords,work->dir_ind);
+	work->icube_vol.set_slope_weights(work->grid_coords);
+	grid->interpolate_metric(work);
+	return -work->Gamma.contract2(k);
 }
 
+// Dormand-Prince 5(4) on (x,k), substepping so the total step is exactly dlambda.
+// The local error is measured relative to the elapsed coordinate time for x
+// and to k^t for k. The last suggested substep is kept in eh->dlambda_geodesic
+// and used to start the next move.
+size_t Transport::integrate_geodesic_adaptive(EinsteinHelper *eh, const double dlambda) const{
+	PRINT_ASSERT(geodesic_tolerance,>,0);
+	static const double a[7][6] = {
+		{0,0,0,0,0,0},
+		{1./5.,0,0,0,0,0},
+		{3./40., 9./40.,0,0,0,0},
+		{44./45., -56./15., 32./9.,0,0,0},
+		{19372./6561., -25360./2187., 64448./6561., -212./729.,0,0},
+		{9017./3168., -355./33., 46732./5247., 49./176., -5103./18656.,0},
+		{35./384., 0., 500./1113., 125./192., -2187./6784., 11./84.}};
+	static const double e[7] = {71./57600., 0., -71./16695., 71./1920., -17253./339200., 22./525., -1./40.};
+
+	EinsteinHelper work; // scratch background for the stages
+	Tuple<double,4> dx[7], dk[7], x, k;
+	dx[0] = eh->kup;
+	dk[0] = eh->dk_dlambda();
+
+	double remaining = dlambda;
+	double h = eh->dlambda_geodesic>0 ? min(eh->dlambda_geodesic, dlambda) : dlambda;
+	size_t nsteps = 0;
+	while(remaining > dlambda*TINY){
+		h = min(h, remaining);
+		nsteps++;
+
+		// stages 2-7. The 7th stage is the new point (first-same-as-last)
+		for(size_t s=1; s<7; s++){
+			x = eh->xup;
+			k = eh->kup;
+			for(size_t j=0; j<s; j++){
+				if(a[s][j]==0) continue;
+				x += dx[j] * (a[s][j]*h);
+				k += dk[j] * (a[s][j]*h);
+			}
+			dx[s] = k;
+			dk[s] = geodesic_acceleration(&work, x, k);
+		}
+
+		// embedded error estimate
+		double err = 0;
+		for(size_t i=0; i<4; i++){
+			double errx=0, errk=0;
+			for(size_t s=0; s<7; s++){
+				errx += e[s]*dx[s][i];
+				errk += e[s]*dk[s][i];
+			}
+			err = max(err, abs(errx) / eh->kup[3]);
+			err = max(err, abs(errk*h) / eh->kup[3]);
+		}
+		err /= geodesic_tolerance;
+
+		// accept or reject, then choose the next substep
+		const double hnew = h * min(5., max(0.2, 0.9*pow(err,-0.2)));
+		if(err<=1 || h<=dlambda*TINY){
+			eh->xup = x;
+			eh->kup = k;
+			dx[0] = dx[6];
+			dk[0] = dk[6];
+			remaining -= h;
+			eh->dlambda_geodesic = hnew;
+		}
+		h = hnew;
+	}
+
+	PRINT_ASSERT(eh->kup,==,eh->kup);
+	return nsteps;
+}
 
 //--------------------------------------------------------
 // Propagate a single monte carlo particle until
@@ -242,11 +618,20 @@ void Transport::propagate(EinsteinHelper *eh){
 		}
 
 		if(eh->fate==moving) window(eh);
+		if(eh->fate==moving and do_weight_windows) weight_window(eh);
 		if(eh->fate==moving) PRINT_ASSERT(abs(eh->g.dot<4>(eh->kup,eh->kup)) / (eh->kup[3]*eh->kup[3]), <=, TINY);
 
 		PRINT_ASSERT(eh->N,<,1e99);
 	}
 
+	finalize_particle(eh);
+}
+
+//--------------------------------------------------------
+// Tally the final state of a particle that has
+// stopped moving
+//--------------------------------------------------------
+void Transport::finalize_particle(const EinsteinHelper *eh){
 	PRINT_ASSERT(eh->fate,!=,moving);
 	double e = eh->N * eh->kup[3];
 	if(eh->fate==escaped){
@@ -52,6 +52,84 @@ void Transport::window(EinsteinHelper *eh) const{
 	}
 }
 
+// split or roulette the particle to bring its energy into the zone's weight window.
+// All copies, including the original, restart on a new random stream whose phase
+// is the old one with the copy's index appended as a hex digit. Phases are then
+// unique within the particle's family by construction, which allows 7 generations
+// of splitting. The new copies go into the thread's bank.
+void Transport::weight_window(EinsteinHelper *eh){
+	PRINT_ASSERT(eh->fate,==,moving);
+	PRINT_ASSERT(eh->z_ind,>=,0);
+	const double center = ww_center[eh->z_ind];
+	if(center <= 0) return;
+	const double lower = 2.0*center / (1.0+weight_window_ratio);
+	const double upper = weight_window_ratio * lower;
+	const double e = eh->N * eh->kup_tet[3];
+
+	// Roulette, surviving particles get the window center
+	if(e < lower){
+		if(rangen.uniform() < e/center) eh->N = center / eh->kup_tet[3];
+		else eh->fate = rouletted;
+	}
+
+	// Split into copies near the window center
+	else if(e > upper and (eh->split_label >> 28) == 0){
+		const size_t nsplit = min((size_t)ceil(e/center), (size_t)MAX_WEIGHT_WINDOW_SPLIT);
+		PRINT_ASSERT(nsplit,<=,16);
+		eh->N /= (double)nsplit;
+		eh->N0 /= (double)nsplit;
+		const uint32_t parent_label = eh->split_label;
+		vector<EinsteinHelper>& bank = thread_split_bank[thread_num()];
+		for(size_t i=1; i<nsplit; i++){
+			bank.push_back(*eh);
+			bank.back().split_label = (parent_label << 4) | i;
+			rangen.start_stream(&bank.back().rng, eh->id, bank.back().split_label);
+		}
+		eh->split_label = parent_label << 4;
+		rangen.start_stream(&eh->rng, eh->id, eh->split_label);
+	}
+}
+
+//------------------------------------------------------------
+// Set the weight window centers from the energy-weighted path
+// length tallies of the step that just finished. The center is
+// proportional to the zone's energy flux in units of the zone
+// size, so each zone visited sees about the same number of
+// particle crossings. It is normalized so that a zone with the
+// average flux has the average emitted particle energy. Both
+// are independent of the windows, so the centers do not drift.
+//------------------------------------------------------------
+void Transport::update_weight_windows(){
+	double emit[2] = {ww_emit_energy, (double)ww_emit_count};
+	if(MPI_nprocs>1){
+		ww_tally.mpi_allsum();
+		MPI_Allreduce(MPI_IN_PLACE, emit, 2, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+	}
+
+	// energy flux in units of the zone size
+	double flux_sum = 0;
+	size_t nvisited = 0;
+	for(size_t z_ind=0; z_ind<grid->rho.size(); z_ind++){
+		ww_center[z_ind] = ww_tally[z_ind] / grid->zone_min_length(z_ind);
+		if(ww_center[z_ind] <= 0) continue;
+		flux_sum += ww_center[z_ind];
+		nvisited++;
+	}
+
+	// zones without particles get no window
+	const double norm = (nvisited>0 and emit[1]>0) ? emit[0]/emit[1] * (double)nvisited / flux_sum : 0;
+	#pragma omp parallel for
+	for(size_t z_ind=0; z_ind<grid->rho.size(); z_ind++){
+		ww_center[z_ind] *= norm;
+		PRINT_ASSERT(ww_center[z_ind],>=,0);
+	}
+	ww_tally.wipe();
+	ww_emit_energy = 0;
+	ww_emit_count = 0;
+
+	if(verbose) cout << "#   update_weight_windows() set windows in " << nvisited << "/" << grid->rho.size() << " zones" << endl;
+}
+
 // choose which type of scattering event to do
 void Transport::scatter(EinsteinHelper *eh, const ParticleEvent event) const{
 	assert(event==elastic_scatter or event==inelastic_scatter);
@@ -75,7 +153,7 @@ void Transport::scatter(EinsteinHelper *eh, const ParticleEvent event) const{
 		}
 	}
 
-	grid->fourforce_abs[eh->z_ind] += (kup_tet_old - eh->kup_tet) * eh->N / eh->zone_fourvolume;
+	zone_tally(eh->z_ind).fourforce_abs += (kup_tet_old - eh->kup_tet) * eh->N / eh->zone_fourvolume;
 }
 
 double Pescape(double x, int sumN){
@@ -184,8 +262,9 @@ void Transport::random_walk(EinsteinHelper *eh) const{
 	  // contribute isotropically
 	  double Eiso = eh->kup_tet[3] * Naverage * ds_iso / (eh->zone_fourvolume*pc::c);
 	  grid->distribution[eh->s]->add_isotropic_single(eh->dir_ind, Eiso);
-	  grid->l_abs[eh->z_ind] += (Nold - Nfinal) * species_list[eh->s]->lepton_number / eh->zone_fourvolume;
-	  grid->fourforce_abs[eh->z_ind] += eh->kup_tet * (Nold - Nfinal) / eh->zone_fourvolume;
+	  zone_tally(eh->z_ind).l_abs += (Nold - Nfinal) * species_list[eh->s]->lepton_number / eh->zone_fourvolume;
+	  zone_tally(eh->z_ind).fourforce_abs += eh->kup_tet * (Nold - Nfinal) / eh->zone_fourvolume;
+	  if(do_weight_windows) zone_tally(eh->z_ind).ww_path += eh->kup_tet[3] * Naverage * ds_iso;
 	  
 	  // move neutrino forward in time
 	  eh->xup[3] += ds_iso * eh->u[3];
@@ -208,7 +287,7 @@ void Transport::random_walk(EinsteinHelper *eh) const{
 	  PRINT_ASSERT(abs(kup_tet_old[3]-eh->kup_tet[3])/kup_tet_old[3],<,TINY);
 
 	  // account for change in the fluid
-	  grid->fourforce_abs[eh->z_ind] += (kup_tet_old - eh->kup_tet) * eh->N / eh->zone_fourvolume;
+	  zone_tally(eh->z_ind).fourforce_abs += (kup_tet_old - eh->kup_tet) * eh->N / eh->zone_fourvolume;
 	  
 	  // move for the small timestep
 	  eh->ds_com = ds_adv;
@@ -226,7 +305,7 @@ void Transport::random_walk(EinsteinHelper *eh) const{
 	  eh->set_kup_tet(kup_tet);
 
 	  // account for change in the fluid
-	  grid->fourforce_abs[eh->z_ind] += (kup_tet_old - eh->kup_tet) * eh->N / eh->zone_fourvolume;
+	  zone_tally(eh->z_ind).fourforce_abs += (kup_tet_old - eh->kup_tet) * eh->N / eh->zone_fourvolume;
 
 	  // move forward
 	  eh->ds_com = ds_free;
@@ -236,49 +315,51 @@ void Transport::random_walk(EinsteinHelper *eh) const{
 	  // select a random outward direction. Use delta=2 to make pdf=costheta
 	  kup_tet_old = eh->kup_tet;
 	  kup_tet     = eh->kup_tet;
-	  do{
-	    isotropic_kup_tet(kup_tet,&rangen);
-	  } while(reject_direction(Metric::dot_Minkowski<3>(kup_tet_old,kup_tet)/(kup_tet[3]*kup_tet[3]), 2.) );
+	  sample_kup_tet(kup_tet, kup_tet_old, 2., &rangen);
 	  eh->set_kup_tet(kup_tet);
 	
 	  // account for change in the fluid
-	  grid->fourforce_abs[eh->z_ind] += (kup_tet_old - eh->kup_tet) * eh->N / eh->zone_fourvolume;
+	  zone_tally(eh->z_ind).fourforce_abs += (kup_tet_old - eh->kup_tet) * eh->N / eh->zone_fourvolume;
 	}
 }
 
 void Transport::sample_scattering_final_state(EinsteinHelper *eh, const Tuple<double,4>& kup_tet_old) const{
 	PRINT_ASSERT(eh->inelastic_scatopac,>,0);
-	PRINT_ASSERT(grid->scattering_delta[eh->s].size(),>,0);
+	PRINT_ASSERT(grid->scattering_kernel[eh->s].size(),>,0);
 	PRINT_ASSERT(kup_tet_old[3],==,eh->kup_tet[3]);
 
-	// rejection sampling to get outgoing frequency bin.
-	size_t igout;
-	double P;
-	do{
-		igout = rangen.uniform_discrete(0, grid->nu_grid_axis.size()-1);
-		P = grid->partial_scat_opac[eh->s][igout].interpolate(eh->icube_spec) / eh->inelastic_scatopac;
-		PRINT_ASSERT(P-1.0,<=,TINY);
-		PRINT_ASSERT(P,>=,0.0);
-	} while(rangen.uniform() > P);
+	// The interpolated kernel is a weighted sum of the kernels at the cube corners.
+	// Pick a corner in proportion to its share of the opacity...
+	const InterpolationCube<NDIMS+1>& icube = eh->icube_spec;
+	double U = rangen.uniform() * eh->inelastic_scatopac;
+	size_t corner = icube.ncorners;
+	for(size_t c=0; c<icube.ncorners; c++){
+		const double P = icube.weights[c] * grid->eas_opac[eh->s][icube.indices[c]][iinelastic];
+		if(P <= 0) continue;
+		corner = c;
+		U -= P;
+		if(U < 0) break;
+	}
+	PRINT_ASSERT(corner,<,icube.ncorners);
+
+	// ...then get the outgoing frequency bin from that corner's alias table
+	const ScatteringKernel& kernel = grid->scattering_kernel[eh->s];
+	size_t igout = kernel.sample(icube.indices[corner], rangen.uniform());
+	PRINT_ASSERT(igout,<,grid->nu_grid_axis.size());
+	PRINT_ASSERT(kernel.get_opac(icube.indices[corner],igout),>,0);
 
 	// Scatter to the center of the new bin.
 	double outnu = grid->nu_grid_axis.mid[igout];
 
 	// interpolate the kernel anisotropy
-	double delta = grid->scattering_delta[eh->s][igout].interpolate(eh->icube_spec);
+	double delta = kernel.interpolate_delta(eh->icube_spec, igout);
 	PRINT_ASSERT(fabs(delta),<,3.0);
 
-	// rejection sample the new direction, but only if not absurdly forward/backward peaked
+	// sample the new direction, but only if not absurdly forward/backward peaked
 	// (delta=2.8 corresponds to a possible factor of 10 in the neutrino weight)
 	Tuple<double,4> kup_tet_new;
 	kup_tet_new[3] = outnu * pc::h;
-	if(fabs(delta) < 2.8){
-		double costheta=0;
-		do{
-			isotropic_kup_tet(kup_tet_new, &rangen);
-			costheta = Metric::dot_Minkowski<3>(kup_tet_new,kup_tet_old) / (kup_tet_old[3]*kup_tet_new[3]);
-		} while(reject_direction(costheta, delta));
-	}
+	if(fabs(delta) < 2.8) sample_kup_tet(kup_tet_new, kup_tet_old, delta, &rangen);
 	else{
 	        kup_tet_new = eh->kup_tet * outnu / eh->nu();
 		if(delta<0) for(size_t i=0; i<3; i++) kup_tet_new[i] = -eh->kup_tet[i];
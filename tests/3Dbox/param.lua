@@ -6,6 +6,7 @@ do_annihilation = 0
 neutrino_type = "grey"
 nugrid_n = 20
 Neutrino_grey_chempot = 10
+Neutrino_grey_tabulated = 0
 nugrid_start = 0
 nugrid_stop = 200
 nugrid_n = 50
@@ -17,6 +18,7 @@ write_zones_every = 1
 
 -- bias parameters
 min_packet_weight = 0.001 --0.707106781 --0.707106781 -- 1/sqrt(2)
+do_weight_windows = 0
 
 -- distribution parameters
 distribution_type = "Moments"
@@ -31,6 +33,7 @@ Grid3DCart_reflect_z=0
 Grid3DCart_rotate_quadrant = 0
 Grid3DCart_rotate_hemisphere_x = 0
 Grid3DCart_rotate_hemisphere_y = 0
+Grid3DCart_precompute_christoffel = 0
 model_file = "stationary.h5"
 
 -- spectrum parameters
@@ -40,6 +43,7 @@ spec_n_phi = 1
 -- particle creation parameters
 n_emit_core_per_bin = 0
 n_emit_therm_per_bin = 100
+n_emit_therm_total = 0
 n_subcycles = 1
 r_core = 0 --7e5
 max_n_iter = 1
@@ -48,7 +52,13 @@ max_time_hours = -1
 -- particle propagation parameters
 min_step_size = 0.05
 max_step_size = 0.5
+geodesic_tolerance = 0
+opacity_cache_file = ""
+inelastic_bandwidth = 0
 absorption_depth_limiter = 1.0
+rng_seed = 1
+do_event_based = 0
+do_streaming = 0
 
 -- randomwalk
 do_randomwalk = 1
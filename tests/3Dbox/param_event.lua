@@ -0,0 +1,69 @@
+verbose = 1
+reflect_outer = 0
+do_annihilation = 0
+
+-- opacity stuff
+neutrino_type = "grey"
+nugrid_n = 20
+Neutrino_grey_chempot = 10
+Neutrino_grey_tabulated = 0
+nugrid_start = 0
+nugrid_stop = 200
+nugrid_n = 50
+Neutrino_grey_opac = 1
+Neutrino_grey_abs_frac = 1
+
+-- output parameters
+write_zones_every = 1
+
+-- bias parameters
+min_packet_weight = 0.001 --0.707106781 --0.707106781 -- 1/sqrt(2)
+do_weight_windows = 0
+
+-- distribution parameters
+distribution_type = "Moments"
+
+-- input/output files
+grid_type = "Grid3DCart"
+model_type = "THC"
+Grid3DCart_THC_reflevel = 0
+Grid3DCart_reflect_x=0
+Grid3DCart_reflect_y=0
+Grid3DCart_reflect_z=0
+Grid3DCart_rotate_quadrant = 0
+Grid3DCart_rotate_hemisphere_x = 0
+Grid3DCart_rotate_hemisphere_y = 0
+Grid3DCart_precompute_christoffel = 0
+model_file = "stationary.h5"
+
+-- spectrum parameters
+spec_n_mu = 1
+spec_n_phi = 1
+
+-- particle creation parameters
+n_emit_core_per_bin = 0
+n_emit_therm_per_bin = 100
+n_emit_therm_total = 0
+n_subcycles = 1
+r_core = 0 --7e5
+max_n_iter = 1
+max_time_hours = -1
+
+-- particle propagation parameters
+min_step_size = 0.05
+max_step_size = 0.5
+geodesic_tolerance = 0
+opacity_cache_file = ""
+inelastic_bandwidth = 0
+absorption_depth_limiter = 1.0
+rng_seed = 1
+do_event_based = 1
+do_streaming = 0
+
+-- randomwalk
+do_randomwalk = 1
+randomwalk_max_x = 2
+randomwalk_sumN = 1000
+randomwalk_npoints = 100
+randomwalk_min_optical_depth = 6
+randomwalk_interpolation_order = 1
@@ -7,6 +7,7 @@ do_randomwalk = 1
 -- Opacity and Emissivity
 
 opacity_dir = "NSY/opacities"
+Nagakura_opacity_file = ""
 
 -- Escape Spectra
 
@@ -36,7 +37,9 @@ write_zones_every   = 1
 n_subcycles = 1
 n_emit_core_per_bin    = 0
 n_emit_therm_per_bin = 1
+n_emit_therm_total = 0
 min_packet_weight = 1e-3
+do_weight_windows = 0
 
 -- Inner Source
 
@@ -48,8 +51,14 @@ verbose       = 1
 max_n_iter =  1
 min_step_size = 0.01
 max_step_size = 0.4
+geodesic_tolerance = 0
+opacity_cache_file = ""
+inelastic_bandwidth = 0
 max_time_hours = -1
 absorption_depth_limiter = 1.0
+rng_seed = 1
+do_event_based = 0
+do_streaming = 0
 
 -- Random Walk
 
@@ -8,6 +8,8 @@ do_annihilation = 0
 neutrino_type = "NuLib"
 nulib_table = "../../external/NuLib/NuLib.h5"
 nulib_eos = "../../external/Hempel_SFHoEOS_rho222_temp180_ye60_version_1.1_20120817.h5"
+nulib_native_interpolation = 0
+nulib_kernel_cache = 0
 
 -- Escape Spectra
 
@@ -36,6 +38,7 @@ write_zones_every   = 1
 n_subcycles = 1
 n_emit_core_per_bin    = 0
 n_emit_therm_per_bin   = 50
+n_emit_therm_total = 0
 
 -- Inner Source
 
@@ -46,11 +49,18 @@ r_core = 0
 verbose       = 1
 min_step_size = 0.01
 max_step_size = 0.4
+geodesic_tolerance = 0
+opacity_cache_file = ""
+inelastic_bandwidth = 0
 absorption_depth_limiter = 1
+rng_seed = 1
+do_event_based = 0
+do_streaming = 0
 
 -- Biasing
 
 min_packet_weight = 0.01
+do_weight_windows = 0
 
 -- Random Walk
 
@@ -8,12 +8,14 @@ nugrid_stop = 10
 Neutrino_grey_abs_frac = 0
 Neutrino_grey_opac = 1
 Neutrino_grey_chempot = 0
+Neutrino_grey_tabulated = 1
 
 -- output parameters
 write_zones_every = 1
 
 -- bias parameters
 min_packet_weight = 0.707106781 --0.707106781 -- 1/sqrt(2)
+do_weight_windows = 0
 
 -- distribution parameters
 distribution_type = "Moments"
@@ -31,6 +33,7 @@ spec_n_phi = 1
 -- particle creation parameters
 n_emit_core_per_bin = 0
 n_emit_therm_per_bin = 1
+n_emit_therm_total = 0
 n_subcycles = 16
 r_core = 0 --7e5
 max_n_iter = 1
@@ -39,7 +42,13 @@ max_time_hours = -1
 -- particle propagation parameters
 min_step_size = 0.05
 max_step_size = 0.5
+geodesic_tolerance = 0
+opacity_cache_file = ""
+inelastic_bandwidth = 0
 absorption_depth_limiter = 1.
+rng_seed = 1
+do_event_based = 0
+do_streaming = 0
 
 -- randomwalk
 do_randomwalk = 1
@@ -31,7 +31,9 @@ with open("output.txt","r") as search:
         if "DO_GR" in line:
             do_gr = int(line[-2])
 
-f = h5py.File("fluid_00001.h5","r")
+# optional argument: the fluid file to check (default: the first step)
+fluid_file = sys.argv[1] if len(sys.argv)>1 else "fluid_00001.h5"
+f = h5py.File(fluid_file,"r")
 r = np.array(f["axes/x0(cm)[mid]"])/1e5
 T_gas = np.array(f["T_gas(K,tet)"])*tools.k_b/tools.MeV
 edens = np.array(f["distribution0(erg|ccm,tet)"]).sum(axis=(1,2,3))/1e29
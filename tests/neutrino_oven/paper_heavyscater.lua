@@ -11,6 +11,7 @@ neutrino_type = "grey"
 Neutrino_grey_opac  = 1
 Neutrino_grey_abs_frac = 1e-9
 Neutrino_grey_chempot = 0.
+Neutrino_grey_tabulated = 0
 nugrid_start = 0
 nugrid_stop = 250
 nugrid_n = 500
@@ -41,6 +42,7 @@ write_zones_every   = 1
 n_subcycles = 35
 n_emit_core_per_bin    = 0 --1000 --10000
 n_emit_therm_per_bin   = 1
+n_emit_therm_total = 0
 max_time_hours = -1
 
 -- Inner Source
@@ -56,11 +58,18 @@ verbose       = 1
 max_n_iter =  1
 min_step_size = 0.25
 max_step_size = 0.25
+geodesic_tolerance = 0
+opacity_cache_file = ""
+inelastic_bandwidth = 0
 absorption_depth_limiter = 1.0
+rng_seed = 1
+do_event_based = 0
+do_streaming = 0
 
 -- Biasing
 
 min_packet_weight = 0.1
+do_weight_windows = 0
 
 -- Random Walk
 
@@ -10,6 +10,7 @@ neutrino_type = "grey"
 Neutrino_grey_abs_frac = 0
 Neutrino_grey_opac = 0
 Neutrino_grey_chempot = 0
+Neutrino_grey_tabulated = 0
 nugrid_n=1
 nugrid_start=0
 nugrid_stop=1e99
@@ -40,6 +41,7 @@ write_zones_every   = 1
 n_subcycles = 1
 n_emit_core_per_bin    = 0
 n_emit_therm_per_bin   = 0
+n_emit_therm_total = 0
 max_time_hours = -1
 
 -- Inner Source
@@ -54,11 +56,18 @@ verbose       = 0
 max_n_iter =  1
 min_step_size = 0.02
 max_step_size = 0.2
+geodesic_tolerance = 0
+opacity_cache_file = ""
+inelastic_bandwidth = 0
 absorption_depth_limiter = 1.0
+rng_seed = 1
+do_event_based = 0
+do_streaming = 0
 
 -- Biasing
 
 min_packet_weight = 0
+do_weight_windows = 0
 
 -- Random Walk
 
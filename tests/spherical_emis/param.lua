@@ -14,6 +14,7 @@ nugrid_stop = 100
 Neutrino_grey_opac = 0
 Neutrino_grey_abs_frac = 0
 Neutrino_grey_chempot = 0
+Neutrino_grey_tabulated = 0
 
 -- Escape Spectra
 
@@ -41,6 +42,7 @@ write_zones_every   = 1
 n_subcycles = 1
 n_emit_core_per_bin    = 10
 n_emit_therm_per_bin   = 0
+n_emit_therm_total = 0
 max_time_hours = -1
 
 -- Inner Source
@@ -56,11 +58,18 @@ verbose       = 1
 max_n_iter =  1
 min_step_size = 0.1
 max_step_size = 0.1
+geodesic_tolerance = 0
+opacity_cache_file = ""
+inelastic_bandwidth = 0
 absorption_depth_limiter = 1.0
+rng_seed = 1
+do_event_based = 0
+do_streaming = 0
 
 -- Biasing
 
 min_packet_weight = 0
+do_weight_windows = 0
 
 -- Random Walk
 